@@ -29,6 +29,53 @@ MACARON_API CarromGameState CarromGameState_New(const CarromGameDef* def);
 MACARON_API void CarromGameState_SetPuckPosition(const CarromGameState* state, int size,
                                                  const CarromObjectPositionDef* positions);
 
+/**
+ * @brief Place a whole layout of pucks at once
+ *
+ * unlike CarromGameState_SetPuckPosition the overlaps are resolved, all pucks of the layout are relaxed together
+ * over a spatial hash until no two pucks overlap and every puck is inside the walls and away from the pockets,
+ * entries which are not pucks are skipped
+ *
+ * @param state game state
+ * @param positions desired puck positions
+ * @param count number of positions
+ * @param layoutDef layout def, see CarromDefaultLayoutDef
+ *
+ * @return true if the final layout is free of overlaps within the tolerance
+ */
+MACARON_API bool CarromGameState_PlaceLayout(const CarromGameState* state, const CarromObjectPositionDef* positions,
+                                             int count, const CarromLayoutDef* layoutDef);
+
+/**
+ * @brief Separate overlapping pucks and bring every object to rest
+ *
+ * overlapping pucks are projected apart and back inside the walls without any dynamic step,
+ * passes stop as soon as no correction exceeds the tolerance, then all velocities are zeroed
+ *
+ * @param state game state
+ * @param tolerance largest overlap accepted, also kept as gap between the pucks
+ * @param maxIters relaxation passes at most
+ *
+ * @return true if the pucks are free of overlaps within the tolerance
+ */
+MACARON_API bool CarromGameState_Settle(const CarromGameState* state, float tolerance, int maxIters);
+
+/**
+ * @brief Default break layout of CarromDefaultPuckPosition, settled
+ *
+ * the settled layout is computed once per table and puck size and kept in the cache,
+ * the cache belongs to the caller, threads sharing one cache must lock it
+ *
+ * @param cache settled layouts, zero initialized before the first use, NULL to settle every call
+ * @param def game definition
+ * @param numOfPucks capacity of positions, at least PUCK_IDX_COUNT
+ * @param positions output positions
+ *
+ * @return number of pucks, PUCK_IDX_COUNT
+ */
+MACARON_API int CarromSettledPuckPosition(CarromSettledLayoutCache* cache, const CarromGameDef* def, int numOfPucks,
+                                          CarromObjectPositionDef* positions);
+
 /**
  * @brief Check if the game state has movement
  *
@@ -64,6 +111,16 @@ MACARON_API void CarromGameState_Step(const CarromGameState* state);
  */
 MACARON_API b2Vec2 CarromGameState_GetPuckPosition(const CarromGameState* state, int index);
 
+/**
+ * @brief Check whether a puck is on the table
+ *
+ * @param state game state
+ * @param index puck index
+ *
+ * @return true if the puck is enabled
+ */
+MACARON_API bool CarromGameState_IsPuckEnabled(const CarromGameState* state, int index);
+
 /**
  * @brief Get striker position
  *
@@ -76,9 +133,9 @@ MACARON_API b2Vec2 CarromGameState_GetStrikerPosition(const CarromGameState* sta
 /**
  * @brief Place puck to the desired position
  *
- * this function will move the puck to the desired position first,
+ * the puck is moved to the closest spot around the desired position where it does not overlap other pucks
  *
- * and then perform collision detection to make sure the puck is not overlapping with other pucks
+ * and stays on the table, the spot is computed in closed form so the cost is bounded even in dense clusters
  *
  * so the final position of the puck might be different from the desired position
  *
@@ -122,17 +179,37 @@ MACARON_API void CarromGameState_DisableStriker(const CarromGameState* state);
 
 MACARON_API bool CarromGameState_IsStrikerEnabled(const CarromGameState* state);
 
+/**
+ * @brief Legal striker ranges along the baseline of a table position
+ *
+ * every enabled puck closer to the baseline than the striker and puck radii removes one interval,
+ * the remaining ranges are computed in closed form
+ *
+ * @param state game state
+ * @param tablePos position on the table
+ * @param out output intervals in increasing order, capacity MAX_STRIKER_INTERVALS,
+ * x for the bottom and top baselines, y for the left and right ones
+ *
+ * @return number of intervals, 0 if the whole baseline is blocked
+ */
+MACARON_API int CarromGameState_StrikerFreeIntervals(const CarromGameState* state, CarromTablePosition tablePos,
+                                                     CarromInterval* out);
+
 /**
  * @brief Place striker to the desired position
  *
  * since there might be some pucks blocking the way,
- * the final position of the striker might be different from the desired position
+ * the final position of the striker might be different from the desired position,
+ * it is snapped to the nearest legal point of CarromGameState_StrikerFreeIntervals
+ *
+ * when the whole baseline is blocked there is no legal point, the striker is then left at the requested spot
+ * limited to the baseline and overlaps a puck, check the returned position with CarromGameState_IsStrikerOverlapping
  *
  * @param state game state
  * @param tablePos position on the table
  * @param pos desire striker translation
  *
- * @return final position of the striker
+ * @return final position of the striker, overlapping a puck only when the whole baseline is blocked
  */
 MACARON_API b2Vec2 CarromGameState_PlaceStriker(const CarromGameState* state, CarromTablePosition tablePos, b2Vec2 pos);
 
@@ -192,6 +269,58 @@ MACARON_API CarromFrame CarromGameState_TakeSnapshot(const CarromGameState* stat
  */
 MACARON_API void CarromGameState_ApplySnapshot(CarromGameState* state, const CarromFrame* frame, bool recreate);
 
+/**
+ * @brief Take full fidelity snapshot of the game state
+ *
+ * velocities, rotations and sleep states are captured as well, the game state does not track pocketed counters,
+ * pass the ones of the running evaluation so they can be carried along
+ *
+ * @param state game state
+ * @param pucksHitPocket number of pucks hit the pocket so far
+ * @param strikerHitPocket striker hit the pocket so far
+ *
+ * @return full snapshot
+ */
+MACARON_API CarromFullSnapshot CarromGameState_TakeFullSnapshot(const CarromGameState* state, int pucksHitPocket,
+                                                                bool strikerHitPocket);
+
+/**
+ * @brief Restore full fidelity snapshot, the simulation continues from where the snapshot was taken
+ *
+ * the disc engines continue exactly, contact caches and sleep timers of Box2D are not restored,
+ * so Box2D states may drift slightly from the original run after the next collision
+ *
+ * @param state game state
+ * @param snapshot full snapshot
+ */
+MACARON_API void CarromGameState_RestoreFullSnapshot(const CarromGameState* state, const CarromFullSnapshot* snapshot);
+
+/**
+ * @brief Copy the live world into other game states so they can continue as alternatives
+ *
+ * objects are copied with CarromGameState_TakeFullSnapshot together with the force of a strike pending
+ * for the next step, the disc engines are copied whole, contact caches and sleep timers of Box2D are not,
+ * so Box2D forks may drift slightly from the source after the next collision
+ *
+ * @param state source game state
+ * @param count number of forks
+ * @param outStates target game states built from the same game def, usually taken from a pool,
+ * states running another engine are skipped
+ *
+ * @return number of forked states
+ */
+MACARON_API int CarromGameState_Fork(const CarromGameState* state, int count, CarromGameState* const* outStates);
+
+/**
+ * @brief Reset game state to the frame in place
+ *
+ * the Box2D world is kept, objects are disabled or moved to the frame positions and their velocities are cleared
+ *
+ * @param state game state
+ * @param frame frame to reset to
+ */
+MACARON_API void CarromGameState_Reset(const CarromGameState* state, const CarromFrame* frame);
+
 /**
  * @brief Let the game state steps until no more movements
  *
@@ -202,9 +331,347 @@ MACARON_API void CarromGameState_ApplySnapshot(CarromGameState* state, const Car
  */
 MACARON_API CarromEvalResult CarromGameState_Eval(const CarromGameState* state, int maxSteps);
 
+/**
+ * @brief Let the game state steps until no more movements, emitting frames to a sink
+ *
+ * only one frame of scratch memory is used, each frame is handed to the sink as soon as it is produced
+ *
+ * @param state game state
+ * @param maxSteps maximum steps allowed, 0 means MAX_FRAME_CAPACITY
+ * @param sink frame sink, return false from it to stop early, can be NULL
+ * @param userData user data passed to the sink
+ *
+ * @return evaluation summary
+ */
+MACARON_API CarromEvalStreamResult CarromGameState_EvalStream(const CarromGameState* state, int maxSteps,
+                                                              CarromFrameSinkFcn* sink, void* userData);
+
+/**
+ * @brief Let the game state steps until no more movements, only the outcome is recorded
+ *
+ * only sensor events are processed during stepping, positions are read once at rest,
+ * use this instead of CarromGameState_Eval when frames are not needed,
+ * with CarromEngine_Event every step jumps straight to the next event
+ *
+ * @param state game state
+ * @param maxSteps maximum steps allowed, 0 means MAX_FRAME_CAPACITY
+ *
+ * @return evaluation outcome
+ */
+MACARON_API CarromEvalOutcome CarromGameState_EvalOutcome(const CarromGameState* state, int maxSteps);
+
+/**
+ * @brief Same as CarromGameState_EvalOutcome but stops as soon as one of the stop conditions holds
+ *
+ * the world is left as it was when the evaluation stopped, bodies may still be moving
+ *
+ * @param state game state
+ * @param maxSteps maximum steps allowed, 0 means MAX_FRAME_CAPACITY
+ * @param stopDef stop conditions, NULL means run until rest
+ *
+ * @return evaluation outcome, stopReason tells which condition ended it
+ */
+MACARON_API CarromEvalOutcome CarromGameState_EvalOutcomeUntil(const CarromGameState* state, int maxSteps,
+                                                               const CarromEvalStopDef* stopDef);
+
+/**
+ * @brief Let the game state steps until no more movements, frames are written into a caller owned trajectory
+ *
+ * only the frames in use are cleared, the trajectory grows on demand and keeps its memory for the next call
+ *
+ * @param state game state
+ * @param maxSteps maximum steps allowed, 0 means no limit other than INT16_MAX
+ * @param trajectory trajectory buffer
+ *
+ * @return number of frames
+ */
+MACARON_API int CarromGameState_EvalInto(const CarromGameState* state, int maxSteps, CarromTrajectory* trajectory);
+
 /**
  * @brief Destroy game state and free memory
  *
  * @param state game state
  */
 MACARON_API void CarromGameState_Destroy(CarromGameState* state);
+
+// Trajectory
+
+/**
+ * @brief Create trajectory buffer
+ *
+ * @param capacity initial number of frames, 0 means MAX_FRAME_CAPACITY
+ *
+ * @return trajectory buffer, capacity is 0 if allocation failed
+ */
+MACARON_API CarromTrajectory CarromTrajectory_Create(int capacity);
+
+/**
+ * @brief Make sure the trajectory can hold at least the given number of frames
+ *
+ * existing frames are kept
+ *
+ * @param trajectory trajectory buffer
+ * @param capacity number of frames
+ *
+ * @return false if allocation failed
+ */
+MACARON_API bool CarromTrajectory_Reserve(CarromTrajectory* trajectory, int capacity);
+
+/**
+ * @brief Destroy trajectory buffer and free memory
+ *
+ * @param trajectory trajectory buffer
+ */
+MACARON_API void CarromTrajectory_Destroy(CarromTrajectory* trajectory);
+
+// Sparse trajectory
+
+/**
+ * @brief Create sparse trajectory buffer
+ *
+ * @param keyframeInterval a keyframe is stored every keyframeInterval frames, 0 means 64
+ *
+ * @return sparse trajectory buffer
+ */
+MACARON_API CarromSparseTrajectory CarromSparseTrajectory_Create(int keyframeInterval);
+
+/**
+ * @brief Clear the sparse trajectory, memory is kept for reuse
+ *
+ * @param trajectory sparse trajectory buffer
+ */
+MACARON_API void CarromSparseTrajectory_Clear(CarromSparseTrajectory* trajectory);
+
+/**
+ * @brief Encode a dense frame and append it to the sparse trajectory
+ *
+ * frames should be appended in order, only objects that moved or changed state are stored
+ *
+ * @param trajectory sparse trajectory buffer
+ * @param frame dense frame
+ *
+ * @return false if allocation failed
+ */
+MACARON_API bool CarromSparseTrajectory_AppendFrame(CarromSparseTrajectory* trajectory, const CarromFrame* frame);
+
+/**
+ * @brief Decode a dense frame from the sparse trajectory
+ *
+ * replays from the nearest keyframe, hit events only belong to the decoded frame
+ *
+ * @param trajectory sparse trajectory buffer
+ * @param index frame index
+ * @param frame output dense frame
+ *
+ * @return false if the index is out of range
+ */
+MACARON_API bool CarromSparseTrajectory_DecodeFrame(const CarromSparseTrajectory* trajectory, int index, CarromFrame* frame);
+
+/**
+ * @brief Destroy sparse trajectory buffer and free memory
+ *
+ * @param trajectory sparse trajectory buffer
+ */
+MACARON_API void CarromSparseTrajectory_Destroy(CarromSparseTrajectory* trajectory);
+
+/**
+ * @brief Let the game state steps until no more movements, frames are encoded into a sparse trajectory
+ *
+ * @param state game state
+ * @param maxSteps maximum steps allowed, 0 means MAX_FRAME_CAPACITY
+ * @param trajectory sparse trajectory buffer, cleared before evaluation
+ *
+ * @return number of frames
+ */
+MACARON_API int CarromGameState_EvalSparse(const CarromGameState* state, int maxSteps, CarromSparseTrajectory* trajectory);
+
+// SoA frame
+
+/**
+ * @brief Convert frame to structure-of-arrays layout
+ *
+ * @param frame source frame
+ * @param soa output frame
+ */
+MACARON_API void CarromFrame_ToSoA(const CarromFrame* frame, CarromFrameSoA* soa);
+
+/**
+ * @brief Convert structure-of-arrays frame back to the regular layout
+ *
+ * @param soa source frame
+ * @param frame output frame
+ */
+MACARON_API void CarromFrameSoA_ToFrame(const CarromFrameSoA* soa, CarromFrame* frame);
+
+// Game state pool
+
+/**
+ * @brief Create game state pool, all states are built up front
+ *
+ * @param def game definition
+ * @param capacity number of states
+ *
+ * @return game state pool, capacity is 0 if allocation failed
+ */
+MACARON_API CarromGameStatePool CarromGameStatePool_Create(const CarromGameDef* def, int capacity);
+
+/**
+ * @brief Take a state from the pool
+ *
+ * the state keeps whatever it had when released, use CarromGameState_Reset before evaluating
+ *
+ * @param pool game state pool
+ *
+ * @return game state, NULL if the pool is exhausted
+ */
+MACARON_API CarromGameState* CarromGameStatePool_Acquire(CarromGameStatePool* pool);
+
+/**
+ * @brief Take a state from the pool and reset it to the frame
+ *
+ * @param pool game state pool
+ * @param frame frame to reset to
+ *
+ * @return game state, NULL if the pool is exhausted
+ */
+MACARON_API CarromGameState* CarromGameStatePool_AcquireReset(CarromGameStatePool* pool, const CarromFrame* frame);
+
+/**
+ * @brief Take states from the pool and fork the game state into them
+ *
+ * @param pool game state pool
+ * @param state source game state
+ * @param count number of forks
+ * @param outStates output game states
+ *
+ * @return number of forked states, smaller than count if the pool is exhausted
+ */
+MACARON_API int CarromGameStatePool_Fork(CarromGameStatePool* pool, const CarromGameState* state, int count,
+                                         CarromGameState** outStates);
+
+/**
+ * @brief Give a state back to the pool
+ *
+ * @param pool game state pool
+ * @param state game state taken from this pool
+ */
+MACARON_API void CarromGameStatePool_Release(CarromGameStatePool* pool, CarromGameState* state);
+
+/**
+ * @brief Destroy all states and free memory
+ *
+ * @param pool game state pool
+ */
+MACARON_API void CarromGameStatePool_Destroy(CarromGameStatePool* pool);
+
+// Batch evaluation
+
+/**
+ * @brief Evaluate shots from the same starting frame across workers
+ *
+ * each worker owns a game state, the starting frame is applied with CarromGameState_ApplySnapshot
+ * before every shot, the striker is placed with CarromGameState_PlaceStriker and then struck,
+ * with lockstep on the disc engine with fixed frames the shots are stepped in groups of one per SIMD lane
+ *
+ * @param def batch def
+ * @param startFrame shared starting frame
+ * @param shots shots to evaluate
+ * @param count number of shots
+ * @param outcomes output outcomes, one per shot
+ *
+ * @return number of shots evaluated, 0 if workerCount exceeds MAX_BATCH_WORKERS
+ */
+MACARON_API int CarromBatchEval(const CarromBatchDef* def, const CarromFrame* startFrame, const CarromShot* shots, int count,
+                                CarromEvalOutcome* outcomes);
+
+// Shot prefilter
+
+/**
+ * @brief Classify a shot with pure geometry, no physics stepping involved
+ *
+ * the striker is swept along the impulse direction to the first puck it touches,
+ * that puck is then swept along the line of centers towards the pockets,
+ * only shots which are certainly hopeless are classified as blocked,
+ * cushion first and indirect shots are classified as needing the simulation
+ *
+ * @param def game definition
+ * @param frame frame to classify against, only enabled pucks are considered
+ * @param shot shot
+ *
+ * @return classification
+ */
+MACARON_API CarromShotPrefilter CarromPrefilterShot(const CarromGameDef* def, const CarromFrame* frame, const CarromShot* shot);
+
+/**
+ * @brief Classify shots with pure geometry, the table layout is only gathered once
+ *
+ * @param def game definition
+ * @param frame frame to classify against
+ * @param shots shots
+ * @param count number of shots
+ * @param results output classifications, one per shot
+ *
+ * @return number of shots which are not blocked
+ */
+MACARON_API int CarromPrefilterShots(const CarromGameDef* def, const CarromFrame* frame, const CarromShot* shots, int count,
+                                     CarromShotPrefilter* results);
+
+// Shot generator
+
+/**
+ * @brief Enumerate plausible shots from the table geometry
+ *
+ * for every enabled puck and pocket the ghost ball contact point is computed and aimed at from
+ * striker positions sampled along the baseline, single cushion banks use mirror images of the table,
+ * candidates whose paths are occluded by other pucks or whose striker would drop into a pocket are skipped
+ *
+ * @param def game definition
+ * @param frame frame to generate shots for
+ * @param generatorDef generator def
+ * @param candidates output candidates
+ * @param capacity capacity of candidates
+ *
+ * @return number of candidates
+ */
+MACARON_API int CarromGenerateShots(const CarromGameDef* def, const CarromFrame* frame,
+                                    const CarromShotGeneratorDef* generatorDef, CarromShotCandidate* candidates,
+                                    int capacity);
+
+// Shot solver
+
+/**
+ * @brief Search striker offset, angle and force for the best shots
+ *
+ * a coarse grid is evaluated in parallel with CarromBatchEval, then the best cells are refined locally,
+ * the search stops when the grid and all refinement rounds are done or the eval or time budget is exhausted
+ *
+ * @param def solver def
+ * @param startFrame starting frame
+ * @param solutions output solutions, ranked best first
+ * @param capacity capacity of solutions
+ *
+ * @return number of solutions
+ */
+MACARON_API int CarromShotSolver_Solve(const CarromShotSolverDef* def, const CarromFrame* startFrame,
+                                       CarromShotSolution* solutions, int capacity);
+
+// Random layout
+
+/**
+ * @brief Generate a random legal mid-game layout
+ *
+ * pucks are thrown one by one as Poisson disc darts, each dart is rejected if it overlaps an accepted puck,
+ * leaves the walls or touches a pocket, a dart lands near a random cluster center with the clustering
+ * chance of the def and anywhere on the table otherwise, the result is reproducible from the rng seed
+ *
+ * @param def random layout def
+ * @param rng random number generator, advanced
+ * @param numBlack number of black pucks, at most 9
+ * @param numWhite number of white pucks, at most 9
+ * @param hasRed whether the red puck is on the table
+ * @param out output positions, capacity PUCK_IDX_COUNT
+ *
+ * @return number of positions written, 0 if the pucks could not be relaxed into a legal layout
+ */
+MACARON_API int CarromRandomLayout(const CarromRandomLayoutDef* def, CarromRng* rng, int numBlack, int numWhite,
+                                   bool hasRed, CarromObjectPositionDef* out);
@@ -18,6 +18,9 @@
 
 #define PUCK_IDX_COUNT 19
 
+// every puck splits the striker baseline at most once
+#define MAX_STRIKER_INTERVALS (PUCK_IDX_COUNT + 1)
+
 extern const int32_t sPuckIndexes[PUCK_IDX_COUNT];
 
 #define MACARON_IS_VALID_PUCK_IDX(i) \
@@ -28,6 +31,18 @@ extern const int32_t sPuckIndexes[PUCK_IDX_COUNT];
 #define MACARON_IS_VALID_OBJ_IDX(i) \
 	((i) == IDX_STRIKER || MACARON_IS_VALID_PUCK_IDX(i))
 
+// Physics backend of a game state
+typedef enum CarromEngineType
+{
+	// general purpose Box2D world
+	CarromEngine_Box2D,
+	// specialized engine for equal discs in a rectangular table
+	CarromEngine_Disc,
+	// disc engine jumping from event to event along the closed form damped motion, sub steps are ignored
+	CarromEngine_Event,
+
+} CarromEngineType;
+
 // Box2D world def
 typedef struct CarromWorldDef
 {
@@ -43,6 +58,18 @@ typedef struct CarromWorldDef
 	bool disableSleep;
 	// frame duration, default is 1/60.0
 	float frameDuration;
+	// time objects have to stay slower than their rest speed before they are considered at rest, default is 0.1
+	float restHoldTime;
+	// pick frame duration and sub steps per frame from body speeds and contact distances, default is false
+	bool adaptiveStep;
+	// longest frame in adaptive mode, frameDuration is the shortest, default is 1/15.0
+	float maxFrameDuration;
+	// most sub steps per frame in adaptive mode, subStep is used near contacts, default is 8
+	int32_t maxSubStep;
+	// distance a body may travel per sub step in adaptive mode, in puck radii, default is 0.5
+	float maxSubStepTravel;
+	// physics backend, default is CarromEngine_Box2D
+	CarromEngineType engine;
 
 } CarromWorldDef;
 
@@ -65,6 +92,8 @@ typedef struct CarromObjectPhysicsDef
 	float shapeRestitution;
 	// shape density
 	float shapeDensity;
+	// linear speed below which the object may rest, 0 leaves it to Box2D sleep, default is 0.05
+	float restSpeed;
 
 } CarromObjectPhysicsDef;
 
@@ -151,6 +180,16 @@ typedef struct CarromStrikerLimitDef
 
 MACARON_API CarromStrikerLimitDef CarromDefaultStrikerLimitDef(void);
 
+// Closed range along the striker baseline, x for the bottom and top baselines, y for the left and right ones
+typedef struct CarromInterval
+{
+	// lower bound
+	float min;
+	// upper bound
+	float max;
+
+} CarromInterval;
+
 // Game def
 typedef struct CarromGameDef
 {
@@ -171,6 +210,76 @@ MACARON_API CarromGameDef CarromDefaultGameDef(void);
 
 MACARON_API int CarromDefaultPuckPosition(float radius, float gap, int numOfPucks, CarromObjectPositionDef *positions);
 
+// Layout placement def
+typedef struct CarromLayoutDef
+{
+	// gap kept between two pucks
+	float clearance;
+	// relaxation passes at most
+	int32_t maxIterations;
+	// largest overlap accepted at the end
+	float tolerance;
+	// disable the pucks missing from the layout, otherwise they stay where they are as obstacles
+	bool disableOthers;
+
+} CarromLayoutDef;
+
+MACARON_API CarromLayoutDef CarromDefaultLayoutDef(void);
+
+#define SETTLED_LAYOUT_CACHE_CAPACITY 8
+
+// Settled break layout of one table and puck size
+typedef struct CarromSettledLayout
+{
+	// world width and height, puck radius and gap, pocket radius and corner offsets
+	float key[7];
+	// settled positions
+	CarromObjectPositionDef positions[PUCK_IDX_COUNT];
+
+} CarromSettledLayout;
+
+// Settled break layouts owned by the caller, zero initialize before the first use, one cache per thread
+typedef struct CarromSettledLayoutCache
+{
+	// cached layouts
+	CarromSettledLayout entries[SETTLED_LAYOUT_CACHE_CAPACITY];
+	// number of cached layouts
+	int32_t count;
+	// entry replaced next once the cache is full
+	int32_t next;
+
+} CarromSettledLayoutCache;
+
+// Seedable random number generator, PCG32, the same seed always gives the same sequence
+typedef struct CarromRng
+{
+	// generator state
+	uint64_t state;
+
+} CarromRng;
+
+MACARON_API CarromRng CarromRng_New(uint64_t seed);
+
+// Random layout def
+typedef struct CarromRandomLayoutDef
+{
+	// table, puck radius and pockets
+	CarromGameDef gameDef;
+	// gap kept between two pucks and between pucks and walls
+	float clearance;
+	// chance in [0, 1] that a puck is thrown near a cluster center rather than anywhere on the table
+	float clustering;
+	// number of cluster centers, picked anew for every layout
+	int32_t numClusters;
+	// radius around a cluster center where its pucks are thrown
+	float clusterRadius;
+	// darts thrown per puck before it goes anywhere on the table
+	int32_t maxAttempts;
+
+} CarromRandomLayoutDef;
+
+MACARON_API CarromRandomLayoutDef CarromDefaultRandomLayoutDef(void);
+
 // Object instance
 typedef struct CarromObject
 {
@@ -202,9 +311,29 @@ typedef struct CarromGameState
 	b2ShapeId pockets[MAX_POCKET_CAPACITY];
 	// objects
 	CarromObject objects[NUM_OF_OBJECTS];
+	// disc world, only used by CarromEngine_Disc, Box2D ids are null then
+	struct CarromDiscWorld* discWorld;
+	// positions and enable flags of the Box2D bodies, NULL with the disc engines
+	struct CarromBodyMirror* mirror;
 
 } CarromGameState;
 
+// Pool of pre-built game states, not thread safe, use one pool per thread
+typedef struct CarromGameStatePool
+{
+	// game def used to build the states
+	CarromGameDef def;
+	// number of states
+	int32_t capacity;
+	// number of free states
+	int32_t freeCount;
+	// states
+	CarromGameState* states;
+	// indexes of free states
+	int32_t* freeList;
+
+} CarromGameStatePool;
+
 typedef enum CarromHitEventType
 {
 	CarromHitEventType_None,
@@ -243,11 +372,45 @@ typedef struct CarromFrame
 	bool strikerHitPocket;
 	// number of pucks hit the pocket
 	int8_t pucksHitPocket;
+	// time since the evaluation started, in seconds, frames are not evenly spaced in adaptive mode
+	float time;
 	// object snapshots
 	CarromObjectSnapshot snapshots[NUM_OF_OBJECTS];
 
 } CarromFrame;
 
+// Full fidelity object snapshot
+typedef struct CarromObjectFullSnapshot
+{
+	// object index, -1 if the object does not exist
+	int8_t index;
+	// enable
+	bool enable;
+	// awake, false if the body is sleeping
+	bool awake;
+	// position
+	b2Vec2 position;
+	// rotation
+	b2Rot rotation;
+	// linear velocity
+	b2Vec2 linearVelocity;
+	// angular velocity
+	float angularVelocity;
+
+} CarromObjectFullSnapshot;
+
+// Full fidelity snapshot, can be taken mid-motion and resumed
+typedef struct CarromFullSnapshot
+{
+	// striker hit the pocket so far
+	bool strikerHitPocket;
+	// number of pucks hit the pocket so far
+	int8_t pucksHitPocket;
+	// object snapshots
+	CarromObjectFullSnapshot objects[NUM_OF_OBJECTS];
+
+} CarromFullSnapshot;
+
 // Frames
 typedef struct CarromEvalResult
 {
@@ -261,3 +424,427 @@ typedef struct CarromEvalResult
 	CarromFrame frames[MAX_FRAME_CAPACITY];
 
 } CarromEvalResult;
+
+/**
+ * @brief Frame sink used by streaming evaluation
+ *
+ * the frame is only valid during the call, copy it if it needs to outlive the callback
+ *
+ * @param frame frame just produced
+ * @param userData user data passed to the evaluation
+ *
+ * @return false to stop the evaluation early
+ */
+typedef bool CarromFrameSinkFcn(const CarromFrame* frame, void* userData);
+
+// Streaming evaluation result, frames are delivered to the sink instead
+typedef struct CarromEvalStreamResult
+{
+	// striker hit the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket
+	int8_t pucksHitPocket;
+	// number of frames produced
+	int16_t numFrames;
+	// stopped by the sink before the objects came to rest
+	bool stopped;
+
+} CarromEvalStreamResult;
+
+// Why an evaluation ended
+typedef enum CarromEvalStopReason
+{
+	// nothing moves anymore
+	CarromEvalStopReason_Rest,
+	// maximum steps reached
+	CarromEvalStopReason_MaxSteps,
+	// striker hit the pocket
+	CarromEvalStopReason_StrikerPocketed,
+	// target puck hit the pocket
+	CarromEvalStopReason_TargetPocketed,
+	// enough pucks hit the pocket
+	CarromEvalStopReason_PucksPocketed,
+	// every body is slower than the minimum speed
+	CarromEvalStopReason_MinSpeed,
+	// no moving body can reach a pocket or another body anymore
+	CarromEvalStopReason_NoReachableContact,
+	// custom stop predicate
+	CarromEvalStopReason_Custom,
+
+} CarromEvalStopReason;
+
+// Outcome of an evaluation, no frames are recorded
+typedef struct CarromEvalOutcome
+{
+	// why the evaluation ended
+	CarromEvalStopReason stopReason;
+	// striker hit the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket, striker included
+	int8_t pucksHitPocket;
+	// number of frames stepped
+	int16_t numFrames;
+	// simulated time, in seconds
+	float time;
+	// object indexes in the order they hit the pocket, first pucksHitPocket entries are valid
+	int8_t pocketedOrder[NUM_OF_OBJECTS];
+	// pocket index for each entry of pocketedOrder
+	int8_t pocketedPocket[NUM_OF_OBJECTS];
+	// enable flags at rest
+	bool enables[NUM_OF_OBJECTS];
+	// final resting positions
+	b2Vec2 positions[NUM_OF_OBJECTS];
+
+} CarromEvalOutcome;
+
+/**
+ * Custom stop predicate, called after every step with the outcome so far, positions are not filled yet
+ *
+ * @return true to stop the evaluation
+ */
+typedef bool CarromEvalStopFcn(const CarromGameState* state, const CarromEvalOutcome* outcome, void* userData);
+
+// Early termination conditions, checked after every step, disabled conditions are skipped
+typedef struct CarromEvalStopDef
+{
+	// stop as soon as the striker hits the pocket
+	bool onStrikerPocketed;
+	// stop as soon as this puck hits the pocket, -1 to disable
+	int8_t targetIndex;
+	// stop once this many pucks hit the pocket, striker excluded, 0 to disable
+	int32_t numPucksPocketed;
+	// stop once every body is slower than this speed, 0 to disable
+	float minSpeed;
+	// stop once no moving body can reach a pocket or another body under linear damping alone,
+	// final positions are extrapolated and folded off the cushions, bodies without linear damping never stop this way
+	bool onNoReachableContact;
+	// custom predicate, NULL to disable
+	CarromEvalStopFcn* customFcn;
+	// user data passed to the custom predicate
+	void* userData;
+
+} CarromEvalStopDef;
+
+MACARON_API CarromEvalStopDef CarromDefaultEvalStopDef(void);
+
+// Caller owned trajectory buffer, reusable across evaluations
+typedef struct CarromTrajectory
+{
+	// striker hit the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket
+	int8_t pucksHitPocket;
+	// number of frames
+	int32_t numFrames;
+	// number of frames allocated
+	int32_t capacity;
+	// frames
+	CarromFrame* frames;
+
+} CarromTrajectory;
+
+// Sparse object flags
+#define MACARON_SPARSE_FLAG_ENABLE 0x01
+#define MACARON_SPARSE_FLAG_REST 0x02
+#define MACARON_SPARSE_FLAG_HIT_POCKET 0x04
+#define MACARON_SPARSE_HIT_EVENT_SHIFT 4
+#define MACARON_SPARSE_HIT_EVENT_MASK 0x30
+
+// Sparse object entry, only stored for objects that moved or changed state
+typedef struct CarromSparseEntry
+{
+	// object index
+	int8_t index;
+	// MACARON_SPARSE_FLAG_* and hit event
+	uint8_t flags;
+	// hit pocket index
+	int8_t hitPocketIndex;
+	// object position
+	b2Vec2 position;
+
+} CarromSparseEntry;
+
+// Sparse frame header
+typedef struct CarromSparseFrame
+{
+	// frame index
+	int16_t index;
+	// striker hits the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket
+	int8_t pucksHitPocket;
+	// time since the evaluation started, in seconds
+	float time;
+	// all valid objects are stored
+	bool keyframe;
+	// number of entries
+	int16_t numEntries;
+	// first entry in CarromSparseTrajectory.entries
+	int32_t firstEntry;
+
+} CarromSparseFrame;
+
+// Sparse trajectory, changed objects per frame plus periodic keyframes
+typedef struct CarromSparseTrajectory
+{
+	// striker hit the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket
+	int8_t pucksHitPocket;
+	// a keyframe is stored every keyframeInterval frames
+	int32_t keyframeInterval;
+	// number of frames
+	int32_t numFrames;
+	// number of frames allocated
+	int32_t frameCapacity;
+	// frames
+	CarromSparseFrame* frames;
+	// number of entries
+	int32_t numEntries;
+	// number of entries allocated
+	int32_t entryCapacity;
+	// entries of all frames
+	CarromSparseEntry* entries;
+	// last stored entry of each object, used to detect changes
+	CarromSparseEntry last[NUM_OF_OBJECTS];
+
+} CarromSparseTrajectory;
+
+#define MACARON_OBJ_BIT(i) (1u << (i))
+
+// Hit record of the SoA frame, only objects with a hit event are stored
+typedef struct CarromHitRecord
+{
+	// object index
+	int8_t index;
+	// hit event, CarromHitEventType
+	int8_t hitEvent;
+	// hit pocket index
+	int8_t hitPocketIndex;
+
+} CarromHitRecord;
+
+// Single frame in structure-of-arrays layout, object flags are bit masks indexed by object index
+typedef struct CarromFrameSoA
+{
+	// frame index
+	int16_t index;
+	// striker hits the pocket
+	bool strikerHitPocket;
+	// number of pucks hit the pocket
+	int8_t pucksHitPocket;
+	// time since the evaluation started, in seconds
+	float time;
+	// objects present in this frame
+	uint32_t validMask;
+	// enabled objects
+	uint32_t enableMask;
+	// objects at rest
+	uint32_t restMask;
+	// objects just hit the pocket
+	uint32_t hitPocketMask;
+	// x positions
+	float x[NUM_OF_OBJECTS];
+	// y positions
+	float y[NUM_OF_OBJECTS];
+	// number of hit records
+	int8_t numHits;
+	// hit records
+	CarromHitRecord hits[NUM_OF_OBJECTS];
+
+} CarromFrameSoA;
+
+// Shot to evaluate
+typedef struct CarromShot
+{
+	// table position of the striker
+	CarromTablePosition tablePos;
+	// desired striker position, resolved by CarromGameState_PlaceStriker
+	b2Vec2 strikerPos;
+	// force applied to the striker
+	b2Vec2 impulse;
+	// maximum force allowed, 0 means no limit
+	float maxForce;
+
+} CarromShot;
+
+#define MAX_BATCH_WORKERS 64
+
+/**
+ * Task interface, same contract as the Box2D task system
+ *
+ * the task must be executed on workers with workerIndex in [0, workerCount)
+ */
+typedef void CarromTaskCallback(int32_t startIndex, int32_t endIndex, uint32_t workerIndex, void* taskContext);
+
+/**
+ * Enqueue a task, return NULL if the task was executed immediately
+ */
+typedef void* CarromEnqueueTaskCallback(CarromTaskCallback* task, int32_t itemCount, int32_t minRange, void* taskContext,
+                                        void* userContext);
+
+/**
+ * Wait for an enqueued task to finish
+ */
+typedef void CarromFinishTaskCallback(void* userTask, void* userContext);
+
+// Batch evaluation def
+typedef struct CarromBatchDef
+{
+	// game def used to build the worker game states
+	CarromGameDef gameDef;
+	// number of workers, must cover every worker index of the task system, at most MAX_BATCH_WORKERS, default is 1
+	int32_t workerCount;
+	// maximum steps of each shot, 0 means MAX_FRAME_CAPACITY
+	int32_t maxSteps;
+	// enqueue task, NULL means shots are evaluated on the calling thread
+	CarromEnqueueTaskCallback* enqueueTask;
+	// finish task
+	CarromFinishTaskCallback* finishTask;
+	// user context passed to the task callbacks
+	void* userTaskContext;
+	// optional pool built from the same game def, worker states are taken from it when possible
+	CarromGameStatePool* statePool;
+	// optional early termination conditions of each shot, NULL means shots run until rest
+	const CarromEvalStopDef* stopDef;
+	// step groups of shots together with the lockstep disc engine, default is false,
+	// only used with CarromEngine_Disc and fixed frames, other engines, adaptive frames
+	// and a stopDef using onNoReachableContact or customFcn evaluate each shot on its own game state,
+	// contacts are solved once per sub step in index order instead of time of impact order,
+	// so outcomes of dense clusters may differ slightly from the per shot path
+	bool lockstep;
+
+} CarromBatchDef;
+
+MACARON_API CarromBatchDef CarromDefaultBatchDef(void);
+
+// Geometric shot classification
+typedef enum CarromShotClass
+{
+	// target puck has a clear path to a pocket
+	CarromShotClass_Clear,
+	// striker is pocketed before touching a puck, starts inside a puck, or other pucks occlude the target's pocket
+	CarromShotClass_Blocked,
+	// striker reaches the cushion first or the target puck does not head straight at a pocket, only the simulation can tell
+	CarromShotClass_NeedsSim,
+
+} CarromShotClass;
+
+// Shot prefilter result
+typedef struct CarromShotPrefilter
+{
+	// classification
+	CarromShotClass shotClass;
+	// first puck touched by the striker, -1 if none
+	int8_t targetIndex;
+	// pocket the target puck heads to, -1 if none
+	int8_t pocketIndex;
+
+} CarromShotPrefilter;
+
+// Kind of generated shot
+typedef enum CarromShotKind
+{
+	// striker hits the target puck straight into the pocket
+	CarromShotKind_Direct,
+	// target puck banks off one cushion into the pocket
+	CarromShotKind_PuckBank,
+	// striker banks off one cushion before hitting the target puck
+	CarromShotKind_StrikerBank,
+
+} CarromShotKind;
+
+// Generated shot candidate
+typedef struct CarromShotCandidate
+{
+	// shot, ready for batch evaluation
+	CarromShot shot;
+	// kind
+	CarromShotKind kind;
+	// target puck index
+	int8_t targetIndex;
+	// pocket index
+	int8_t pocketIndex;
+	// cushion index used by bank shots, 0: left, 1: right, 2: bottom, 3: top, -1 for direct shots
+	int8_t cushion;
+	// cosine of the cut angle, 1 means a full hit
+	float cutCos;
+
+} CarromShotCandidate;
+
+// Shot generator def
+typedef struct CarromShotGeneratorDef
+{
+	// table position of the striker
+	CarromTablePosition tablePos;
+	// number of striker positions sampled along the baseline
+	int32_t baselineSamples;
+	// force of the generated shots
+	float power;
+	// minimum cosine of the cut angle, thinner cuts are skipped
+	float minCutCos;
+	// generate shots where the target puck banks off a cushion
+	bool puckBanks;
+	// generate shots where the striker banks off a cushion
+	bool strikerBanks;
+
+} CarromShotGeneratorDef;
+
+MACARON_API CarromShotGeneratorDef CarromDefaultShotGeneratorDef(void);
+
+// Shot solver def
+typedef struct CarromShotSolverDef
+{
+	// batch def used to evaluate candidates
+	CarromBatchDef batchDef;
+	// table position of the striker
+	CarromTablePosition tablePos;
+	// striker offset range along the baseline, both 0 means the whole striker limit
+	float offsetMin;
+	float offsetMax;
+	// angle range in radians, 0 points from the baseline towards the table center
+	float angleMin;
+	float angleMax;
+	// force range
+	float powerMin;
+	float powerMax;
+	// coarse grid resolution
+	int32_t offsetSteps;
+	int32_t angleSteps;
+	int32_t powerSteps;
+	// number of refinement rounds, the cell size is halved every round
+	int32_t refineRounds;
+	// number of best cells refined every round
+	int32_t refineCells;
+	// maximum number of evaluations, 0 means no limit
+	int32_t maxEvals;
+	// maximum time in milliseconds, 0 means no limit
+	float maxMilliseconds;
+	// skip candidates classified as blocked by CarromPrefilterShot
+	bool prefilter;
+	// score of every pocketed puck
+	float pocketScore;
+	// penalty when the striker is pocketed
+	float foulPenalty;
+
+} CarromShotSolverDef;
+
+MACARON_API CarromShotSolverDef CarromDefaultShotSolverDef(void);
+
+// Shot solver solution
+typedef struct CarromShotSolution
+{
+	// striker offset along the baseline
+	float offset;
+	// angle in radians
+	float angle;
+	// force
+	float power;
+	// shot
+	CarromShot shot;
+	// outcome
+	CarromEvalOutcome outcome;
+	// score, higher is better
+	float score;
+
+} CarromShotSolution;
@@ -8,6 +8,8 @@ typedef struct CarromEvalResultViewer
 	b2Vec2 positions[NUM_OF_OBJECTS];
 	bool rest[NUM_OF_OBJECTS];
 
+	float time;
+
 	float radius[CarromObjectType_Count];
 
 	b2Vec2 pocketsPosition[MAX_POCKET_CAPACITY];
@@ -23,3 +25,15 @@ typedef struct CarromEvalResultViewer
 MACARON_API CarromEvalResultViewer CarromEvalResultViewerCreate(const CarromGameState* state);
 
 MACARON_API void CarromEvalResultViewer_Update(CarromEvalResultViewer* viewer, const CarromFrame* frame);
+
+/**
+ * Show the trajectory at a given time, positions are interpolated between the surrounding frames,
+ * use this to play back frames of uneven duration at a steady rate
+ */
+MACARON_API void CarromEvalResultViewer_UpdateAt(CarromEvalResultViewer* viewer, const CarromFrame* frames, int numFrames,
+                                                 float time);
+
+MACARON_API void CarromEvalResultViewer_UpdateSparse(CarromEvalResultViewer* viewer, const CarromSparseTrajectory* trajectory,
+                                                     int index);
+
+MACARON_API void CarromEvalResultViewer_UpdateSoA(CarromEvalResultViewer* viewer, const CarromFrameSoA* frame);
@@ -61,7 +61,7 @@ void dump_game_state_to_png(const CarromGameState* state, const char* file_path)
 	for (int i = 0; i < PUCK_IDX_COUNT; i++)
 	{
 		const int idx = sPuckIndexes[i];
-		if (!b2Body_IsEnabled(state->objects[idx].bodyId))
+		if (!CarromGameState_IsPuckEnabled(state, idx))
 		{
 			continue;
 		}
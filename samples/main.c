@@ -4,6 +4,7 @@
 #include "macaron/macaron.h"
 
 #include "dumper.h"
+#include "scheduler.h"
 
 CarromGameDef load_game_def()
 {
@@ -14,15 +15,14 @@ CarromGameState new_game_state(const CarromGameDef* gameDef)
 {
 	const CarromGameState state = CarromGameState_New(gameDef);
 
+	// samples create their states on the main thread only
+	static CarromSettledLayoutCache settledCache = {0};
+
 	CarromObjectPositionDef puckPosArr[PUCK_IDX_COUNT];
-	CarromDefaultPuckPosition(gameDef->puckPhysicsDef.radius, gameDef->puckPhysicsDef.gap, PUCK_IDX_COUNT, puckPosArr);
+	CarromSettledPuckPosition(&settledCache, gameDef, PUCK_IDX_COUNT, puckPosArr);
 
 	CarromGameState_SetPuckPosition(&state, PUCK_IDX_COUNT, puckPosArr);
-
-	for (int i = 0; i < 16; i++)
-	{
-		CarromGameState_Step(&state);
-	}
+	CarromGameState_Settle(&state, 0.0001f, 64);
 
 	return state;
 }
@@ -45,7 +45,7 @@ void sample_place_striker()
 	for (int i = 0; i < PUCK_IDX_COUNT; i++)
 	{
 		const int idx = sPuckIndexes[i];
-		b2Body_Disable(state.objects[idx].bodyId);
+		CarromGameState_PlacePuckToPosUnsafe(&state, idx, CarromGameState_GetPuckPosition(&state, idx), false);
 	}
 
 	{
@@ -55,7 +55,6 @@ void sample_place_striker()
 		pos.y = state.strikerLimitDef.centerOffset;
 		pos.x = state.puckPhysicsDef.radius;
 
-		b2Body_Enable(state.objects[idx].bodyId);
 		CarromGameState_PlacePuckToPosUnsafe(&state, idx, pos, true);
 	}
 
@@ -131,8 +130,7 @@ void sample_strike()
 
 		CarromGameState_Step(&state);
 
-		const b2BodyEvents events = b2World_GetBodyEvents(state.worldId);
-		if (events.moveCount == 0)
+		if (!CarromGameState_HasMovement(&state))
 		{
 			CarromGameState_DisableStriker(&state);
 			printf("no more moves, break early, steps: %d\n", i);
@@ -163,8 +161,7 @@ void sample_take_snapshot()
 	{
 		CarromGameState_Step(&state);
 
-		const b2BodyEvents events = b2World_GetBodyEvents(state.worldId);
-		if (events.moveCount == 0)
+		if (!CarromGameState_HasMovement(&state))
 		{
 			CarromGameState_DisableStriker(&state);
 			printf("no more moves, break early, steps: %d\n", i);
@@ -200,47 +197,45 @@ void sample_take_snapshot()
 
 b2Vec2 find_pocket_impulse(const CarromTablePosition tablePos, const int numOfGoals)
 {
-	b2Vec2 initialImpulse = b2Vec2_zero;
-	if (tablePos == CarromTablePosition_Top)
-	{
-		initialImpulse.x = -150.0f;
-	}
-	else if (tablePos == CarromTablePosition_Bottom)
-	{
-		initialImpulse.x = 150.0f;
-	}
-	else if (tablePos == CarromTablePosition_Left)
-	{
-		initialImpulse.y = 150.0f;
-	}
-	else if (tablePos == CarromTablePosition_Right)
-	{
-		initialImpulse.y = -150.0f;
-	}
-
-	const float rotStep = M_PI / 180.0f;
-	float rot = 0.0f;
-
 	const CarromGameDef def = load_game_def();
-	while (true)
-	{
-		const b2Rot bRot = b2MakeRot(rot);
-		rot += rotStep;
-
-		const b2Vec2 impulse = b2RotateVector(bRot, initialImpulse);
-
-		const CarromGameState state = new_game_state(&def);
-		// strike!
-		CarromGameState_PlaceStriker(&state, tablePos, b2Vec2_zero);
-		CarromGameState_Strike(&state, impulse, 0.0f);
 
-		// eval
-		const CarromEvalResult result = CarromGameState_Eval(&state, 0);
-		if (!result.strikerHitPocket && result.pucksHitPocket >= numOfGoals)
+	// settle the layout once, every candidate starts from this frame
+	CarromGameState initialState = new_game_state(&def);
+	const CarromFrame startFrame = CarromGameState_TakeSnapshot(&initialState);
+	CarromGameState_Destroy(&initialState);
+
+	scheduler_init();
+
+	CarromShotSolverDef solverDef = CarromDefaultShotSolverDef();
+	solverDef.batchDef.gameDef = def;
+	solverDef.batchDef.workerCount = scheduler_worker_count();
+	solverDef.batchDef.enqueueTask = scheduler_enqueue_task;
+	solverDef.batchDef.finishTask = scheduler_finish_task;
+	solverDef.tablePos = tablePos;
+	// the striker stays at the center of the baseline, like the old angle sweep
+	solverDef.offsetSteps = 1;
+	solverDef.powerMin = 150.0f;
+	solverDef.powerMax = 150.0f;
+	solverDef.powerSteps = 1;
+	solverDef.angleMin = -b2_pi;
+	solverDef.angleMax = b2_pi;
+	solverDef.angleSteps = 360;
+
+	CarromShotSolution solutions[8];
+	const int numSolutions = CarromShotSolver_Solve(&solverDef, &startFrame, solutions, 8);
+
+	scheduler_shutdown();
+
+	for (int i = 0; i < numSolutions; i++)
+	{
+		const CarromEvalOutcome* outcome = &solutions[i].outcome;
+		if (!outcome->strikerHitPocket && outcome->pucksHitPocket >= numOfGoals)
 		{
-			return impulse;
+			return solutions[i].shot.impulse;
 		}
 	}
+
+	return numSolutions > 0 ? solutions[0].shot.impulse : b2Vec2_zero;
 }
 
 void sample_eval()
@@ -256,15 +251,83 @@ void sample_eval()
 	CarromGameState_PlaceStriker(&state, CarromTablePosition_Top, b2Vec2_zero);
 	CarromGameState_Strike(&state, impulse, 0.0f);
 
-	// eval
-	const CarromEvalResult result = CarromGameState_Eval(&state, 0);
-	printf("frame count: %d\n", result.numFrames);
+	// eval into a reusable buffer
+	CarromTrajectory trajectory = CarromTrajectory_Create(0);
+	CarromGameState_EvalInto(&state, 0, &trajectory);
+	printf("frame count: %d\n", trajectory.numFrames);
 
-	for (int i = 0; i < result.numFrames; i++)
+	for (int i = 0; i < trajectory.numFrames; i++)
 	{
-		const CarromFrame* frame = &result.frames[i];
+		const CarromFrame* frame = &trajectory.frames[i];
 		CarromEvalResultViewer_Update(&viewer, frame);
 	}
+
+	CarromTrajectory_Destroy(&trajectory);
+}
+
+void sample_adaptive_step()
+{
+	const b2Vec2 impulse = {-28.621f, -148.244f};
+
+	CarromGameDef def = load_game_def();
+	def.worldDef.adaptiveStep = true;
+
+	const CarromGameState state = new_game_state(&def);
+	CarromEvalResultViewer viewer = CarromEvalResultViewerCreate(&state);
+
+	CarromGameState_PlaceStriker(&state, CarromTablePosition_Top, b2Vec2_zero);
+	CarromGameState_Strike(&state, impulse, 0.0f);
+
+	CarromTrajectory trajectory = CarromTrajectory_Create(0);
+	CarromGameState_EvalInto(&state, 0, &trajectory);
+
+	const float duration = trajectory.numFrames > 0 ? trajectory.frames[trajectory.numFrames - 1].time : 0.0f;
+	printf("frame count: %d, duration: %.3f\n", trajectory.numFrames, duration);
+
+	// frames are unevenly spaced, play them back at a steady rate
+	for (float time = 0.0f; time <= duration; time += def.worldDef.frameDuration)
+	{
+		CarromEvalResultViewer_UpdateAt(&viewer, trajectory.frames, trajectory.numFrames, time);
+	}
+
+	CarromTrajectory_Destroy(&trajectory);
+}
+
+void sample_disc_engine()
+{
+	const b2Vec2 impulse = {-28.621f, -148.244f};
+
+	CarromGameDef def = load_game_def();
+	def.worldDef.engine = CarromEngine_Disc;
+
+	CarromGameState state = new_game_state(&def);
+
+	CarromGameState_PlaceStriker(&state, CarromTablePosition_Top, b2Vec2_zero);
+	CarromGameState_Strike(&state, impulse, 0.0f);
+
+	const CarromEvalOutcome outcome = CarromGameState_EvalOutcome(&state, 0);
+	printf("pucks pocketed: %d, striker pocketed: %d\n", outcome.pucksHitPocket, outcome.strikerHitPocket);
+
+	CarromGameState_Destroy(&state);
+}
+
+void sample_event_engine()
+{
+	const b2Vec2 impulse = {-28.621f, -148.244f};
+
+	CarromGameDef def = load_game_def();
+	def.worldDef.engine = CarromEngine_Event;
+
+	CarromGameState state = new_game_state(&def);
+
+	CarromGameState_PlaceStriker(&state, CarromTablePosition_Top, b2Vec2_zero);
+	CarromGameState_Strike(&state, impulse, 0.0f);
+
+	// every step ends at the next contact, pocket or sleep event
+	const CarromEvalOutcome outcome = CarromGameState_EvalOutcome(&state, 0);
+	printf("steps: %d, time: %.3f, pucks pocketed: %d\n", outcome.numFrames, outcome.time, outcome.pucksHitPocket);
+
+	CarromGameState_Destroy(&state);
 }
 
 b2Vec2 sample_eval_any(const CarromTablePosition tablePos)
@@ -440,15 +503,196 @@ void sample_hit_pocket_index()
 	}
 }
 
+typedef struct
+{
+	CarromEvalResultViewer viewer;
+	int pucksToWatch;
+} EvalStreamSampleData;
+
+bool sample_eval_stream_sink(const CarromFrame* frame, void* userData)
+{
+	EvalStreamSampleData* data = userData;
+	CarromEvalResultViewer_Update(&data->viewer, frame);
+
+	// stop as soon as enough pucks are pocketed
+	return frame->pucksHitPocket < data->pucksToWatch;
+}
+
+void sample_eval_stream()
+{
+	const b2Vec2 impulse = {-28.621f, -148.244f};
+
+	const CarromGameDef def = load_game_def();
+	const CarromGameState state = new_game_state(&def);
+
+	EvalStreamSampleData data = {0};
+	data.viewer = CarromEvalResultViewerCreate(&state);
+	data.pucksToWatch = 1;
+
+	// strike!
+	CarromGameState_PlaceStriker(&state, CarromTablePosition_Top, b2Vec2_zero);
+	CarromGameState_Strike(&state, impulse, 0.0f);
+
+	const CarromEvalStreamResult result = CarromGameState_EvalStream(&state, 0, sample_eval_stream_sink, &data);
+	printf("frame count: %d, pucksHitPocket: %d, stopped: %d\n", result.numFrames, result.pucksHitPocket, result.stopped);
+}
+
+void sample_batch_eval()
+{
+	const CarromGameDef def = load_game_def();
+	const CarromGameState state = new_game_state(&def);
+	const CarromFrame startFrame = CarromGameState_TakeSnapshot(&state);
+
+	// one shot per degree
+	enum { numShots = 360 };
+	CarromShot shots[numShots];
+	for (int i = 0; i < numShots; i++)
+	{
+		const b2Rot rot = b2MakeRot((float)(i * M_PI / 180.0));
+		shots[i].tablePos = CarromTablePosition_Bottom;
+		shots[i].strikerPos = b2Vec2_zero;
+		shots[i].impulse = b2RotateVector(rot, (b2Vec2){150.0f, 0.0f});
+		shots[i].maxForce = 0.0f;
+	}
+
+	scheduler_init();
+
+	CarromBatchDef batchDef = CarromDefaultBatchDef();
+	batchDef.gameDef = def;
+	batchDef.workerCount = scheduler_worker_count();
+	batchDef.enqueueTask = scheduler_enqueue_task;
+	batchDef.finishTask = scheduler_finish_task;
+
+	// fouls are dropped anyway, stop them early, as well as shots that can not touch anything anymore
+	CarromEvalStopDef stopDef = CarromDefaultEvalStopDef();
+	stopDef.onStrikerPocketed = true;
+	stopDef.onNoReachableContact = true;
+	batchDef.stopDef = &stopDef;
+
+	static CarromEvalOutcome outcomes[numShots];
+	CarromBatchEval(&batchDef, &startFrame, shots, numShots, outcomes);
+
+	for (int i = 0; i < numShots; i++)
+	{
+		if (!outcomes[i].strikerHitPocket && outcomes[i].pucksHitPocket > 0)
+		{
+			printf("shot %d: pucksHitPocket: %d, impulse: (%.3f, %.3f)\n", i, outcomes[i].pucksHitPocket,
+			       shots[i].impulse.x, shots[i].impulse.y);
+		}
+	}
+
+	scheduler_shutdown();
+}
+
+void sample_batch_lockstep()
+{
+	// same engine on both paths, so only the lockstep contact ordering differs
+	CarromGameDef def = load_game_def();
+	def.worldDef.engine = CarromEngine_Disc;
+	const CarromGameState state = new_game_state(&def);
+	const CarromFrame startFrame = CarromGameState_TakeSnapshot(&state);
+
+	enum { numShots = 90 };
+	CarromShot shots[numShots];
+	for (int i = 0; i < numShots; i++)
+	{
+		const b2Rot rot = b2MakeRot((float)((45 + i) * M_PI / 180.0));
+		shots[i].tablePos = CarromTablePosition_Bottom;
+		shots[i].strikerPos = b2Vec2_zero;
+		shots[i].impulse = b2RotateVector(rot, (b2Vec2){150.0f, 0.0f});
+		shots[i].maxForce = 0.0f;
+	}
+
+	// lockstep runs only without the reachable contact check
+	CarromEvalStopDef stopDef = CarromDefaultEvalStopDef();
+	stopDef.onStrikerPocketed = true;
+
+	CarromBatchDef batchDef = CarromDefaultBatchDef();
+	batchDef.gameDef = def;
+	batchDef.stopDef = &stopDef;
+
+	static CarromEvalOutcome perShot[numShots];
+	static CarromEvalOutcome lockstep[numShots];
+	batchDef.lockstep = false;
+	CarromBatchEval(&batchDef, &startFrame, shots, numShots, perShot);
+	batchDef.lockstep = true;
+	CarromBatchEval(&batchDef, &startFrame, shots, numShots, lockstep);
+
+	int numDiffering = 0;
+	float maxDistance = 0.0f;
+	for (int i = 0; i < numShots; i++)
+	{
+		const bool differs = perShot[i].strikerHitPocket != lockstep[i].strikerHitPocket ||
+		                     perShot[i].pucksHitPocket != lockstep[i].pucksHitPocket;
+		numDiffering += differs ? 1 : 0;
+		if (differs)
+		{
+			printf("shot %d: pucksHitPocket: %d vs %d, strikerHitPocket: %d vs %d\n", i, perShot[i].pucksHitPocket,
+			       lockstep[i].pucksHitPocket, perShot[i].strikerHitPocket, lockstep[i].strikerHitPocket);
+		}
+
+		for (int j = 0; j < NUM_OF_OBJECTS; j++)
+		{
+			if (perShot[i].enables[j] && lockstep[i].enables[j])
+			{
+				const float distance = b2Distance(perShot[i].positions[j], lockstep[i].positions[j]);
+				maxDistance = distance > maxDistance ? distance : maxDistance;
+			}
+		}
+	}
+
+	printf("shots: %d, differing outcomes: %d, max position distance: %.4f\n", numShots, numDiffering, maxDistance);
+}
+
+void sample_generate_shots()
+{
+	const CarromGameDef def = load_game_def();
+	const CarromGameState state = new_game_state(&def);
+	const CarromFrame startFrame = CarromGameState_TakeSnapshot(&state);
+
+	const CarromShotGeneratorDef generatorDef = CarromDefaultShotGeneratorDef();
+
+	enum { maxCandidates = 512 };
+	static CarromShotCandidate candidates[maxCandidates];
+	static CarromShot shots[maxCandidates];
+	static CarromEvalOutcome outcomes[maxCandidates];
+	const int numCandidates = CarromGenerateShots(&def, &startFrame, &generatorDef, candidates, maxCandidates);
+	for (int i = 0; i < numCandidates; i++)
+	{
+		shots[i] = candidates[i].shot;
+	}
+
+	CarromBatchDef batchDef = CarromDefaultBatchDef();
+	batchDef.gameDef = def;
+	CarromBatchEval(&batchDef, &startFrame, shots, numCandidates, outcomes);
+
+	printf("candidates: %d\n", numCandidates);
+	for (int i = 0; i < numCandidates; i++)
+	{
+		if (!outcomes[i].strikerHitPocket && outcomes[i].pucksHitPocket > 0)
+		{
+			printf("kind %d, target %d, pocket %d, cushion %d: pucksHitPocket: %d\n", candidates[i].kind,
+			       candidates[i].targetIndex, candidates[i].pocketIndex, candidates[i].cushion, outcomes[i].pucksHitPocket);
+		}
+	}
+}
+
 int main(int argc, char** argv)
 {
 	// sample_take_snapshot();
 	// sample_userdata();
 	// sample_eval();
+	// sample_adaptive_step();
+	// sample_disc_engine();
+	// sample_event_engine();
 	// sample_eval_with_picture_output();
 	// sample_place_striker();
 	// sample_eval_any(CarromTablePosition_Left);
 	// sample_apply_velocity();
+	// sample_eval_stream();
+	// sample_batch_eval();
+	// sample_batch_lockstep();
+	// sample_generate_shots();
 	sample_hit_pocket_index();
 
 	return 0;
@@ -0,0 +1,75 @@
+#include "scheduler.h"
+
+#include "TaskScheduler_c.h"
+
+#include <stdlib.h>
+
+typedef struct
+{
+	enkiTaskSet* taskSet;
+	CarromTaskCallback* task;
+	void* taskContext;
+} SchedulerTask;
+
+static enkiTaskScheduler* scheduler = NULL;
+
+void scheduler_init(void)
+{
+	if (scheduler != NULL)
+	{
+		return;
+	}
+
+	scheduler = enkiNewTaskScheduler();
+	enkiInitTaskScheduler(scheduler);
+}
+
+void scheduler_shutdown(void)
+{
+	if (scheduler == NULL)
+	{
+		return;
+	}
+
+	enkiDeleteTaskScheduler(scheduler);
+	scheduler = NULL;
+}
+
+int scheduler_worker_count(void)
+{
+	return scheduler != NULL ? (int)enkiGetNumTaskThreads(scheduler) : 1;
+}
+
+static void scheduler_execute_range(const uint32_t start, const uint32_t end, const uint32_t threadnum, void* args)
+{
+	const SchedulerTask* task = args;
+	task->task((int32_t)start, (int32_t)end, threadnum, task->taskContext);
+}
+
+void* scheduler_enqueue_task(CarromTaskCallback* task, const int32_t itemCount, const int32_t minRange, void* taskContext,
+                             void* userContext)
+{
+	// each task owns its handle, tasks may be enqueued from several threads and finish in any order
+	SchedulerTask* schedulerTask = scheduler != NULL ? malloc(sizeof(SchedulerTask)) : NULL;
+	if (schedulerTask == NULL)
+	{
+		// run inline
+		task(0, itemCount, 0, taskContext);
+		return NULL;
+	}
+
+	schedulerTask->task = task;
+	schedulerTask->taskContext = taskContext;
+	schedulerTask->taskSet = enkiCreateTaskSet(scheduler, scheduler_execute_range);
+	enkiAddTaskSetMinRange(scheduler, schedulerTask->taskSet, schedulerTask, (uint32_t)itemCount, (uint32_t)minRange);
+
+	return schedulerTask;
+}
+
+void scheduler_finish_task(void* userTask, void* userContext)
+{
+	SchedulerTask* schedulerTask = userTask;
+	enkiWaitForTaskSet(scheduler, schedulerTask->taskSet);
+	enkiDeleteTaskSet(scheduler, schedulerTask->taskSet);
+	free(schedulerTask);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <macaron/types.h>
+
+extern void scheduler_init(void);
+
+extern void scheduler_shutdown(void);
+
+extern int scheduler_worker_count(void);
+
+extern void* scheduler_enqueue_task(CarromTaskCallback* task, int32_t itemCount, int32_t minRange, void* taskContext,
+                                    void* userContext);
+
+extern void scheduler_finish_task(void* userTask, void* userContext);
@@ -0,0 +1,205 @@
+#include "core.h"
+#include "disc_lanes.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+
+typedef struct CarromBatchContext
+{
+	CarromGameState** states;
+	int workerCount;
+	const CarromFrame* startFrame;
+	const CarromShot* shots;
+	CarromEvalOutcome* outcomes;
+	int count;
+	int maxSteps;
+	const CarromEvalStopDef* stopDef;
+} CarromBatchContext;
+
+CarromEvalOutcome CarromBatch_EvalShot(const CarromGameState* state, const CarromFrame* startFrame, const CarromShot* shot,
+                                       const int maxSteps, const CarromEvalStopDef* stopDef)
+{
+	CarromGameState_Reset(state, startFrame);
+
+	CarromGameState_PlaceStriker(state, shot->tablePos, shot->strikerPos);
+	CarromGameState_Strike(state, shot->impulse, shot->maxForce);
+
+	return CarromGameState_EvalOutcomeUntil(state, maxSteps, stopDef);
+}
+
+static void CarromBatch_Task(const int32_t startIndex, const int32_t endIndex, const uint32_t workerIndex, void* taskContext)
+{
+	const CarromBatchContext* context = taskContext;
+	MACARON_ASSERT(workerIndex < (uint32_t)context->workerCount);
+	const CarromGameState* state = context->states[workerIndex];
+
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		context->outcomes[i] = CarromBatch_EvalShot(state, context->startFrame, &context->shots[i], context->maxSteps,
+		                                            context->stopDef);
+	}
+}
+
+/**
+ * Evaluate one group of up to CARROM_LANES shots in lockstep, the worker state only places the striker
+ */
+static void CarromBatch_EvalLanes(const CarromGameState* state, const CarromFrame* startFrame, const CarromShot* shots,
+                                  const int count, const int maxSteps, const CarromEvalStopDef* stopDef,
+                                  CarromEvalOutcome* outcomes)
+{
+	CarromGameState_Reset(state, startFrame);
+
+	CarromDiscLanes lanes;
+	CarromDiscLanes_Init(&lanes, state, startFrame);
+
+	for (int lane = 0; lane < count; lane++)
+	{
+		const CarromShot* shot = &shots[lane];
+		const b2Vec2 strikerPos = CarromGameState_PlaceStriker(state, shot->tablePos, shot->strikerPos);
+
+		// same clamp as CarromGameState_Strike
+		b2Vec2 force = shot->impulse;
+		const float length = b2Length(force);
+		if (shot->maxForce > 0.0f && length > shot->maxForce)
+		{
+			force = b2MulSV(shot->maxForce / length, force);
+		}
+
+		CarromDiscLanes_SetShot(&lanes, lane, strikerPos, force);
+	}
+
+	CarromEvalOutcome laneOutcomes[CARROM_LANES];
+	CarromDiscLanes_Eval(&lanes, maxSteps, stopDef, laneOutcomes);
+
+	for (int lane = 0; lane < count; lane++)
+	{
+		outcomes[lane] = laneOutcomes[lane];
+	}
+}
+
+static void CarromBatch_LockstepTask(const int32_t startIndex, const int32_t endIndex, const uint32_t workerIndex,
+                                     void* taskContext)
+{
+	const CarromBatchContext* context = taskContext;
+	MACARON_ASSERT(workerIndex < (uint32_t)context->workerCount);
+	const CarromGameState* state = context->states[workerIndex];
+
+	// items are groups of CARROM_LANES shots
+	for (int group = startIndex; group < endIndex; group++)
+	{
+		const int first = group * CARROM_LANES;
+		const int remaining = context->count - first;
+		const int count = remaining < CARROM_LANES ? remaining : CARROM_LANES;
+		CarromBatch_EvalLanes(state, context->startFrame, &context->shots[first], count, context->maxSteps,
+		                      context->stopDef, &context->outcomes[first]);
+	}
+}
+
+int CarromBatchEval(const CarromBatchDef* def, const CarromFrame* startFrame, const CarromShot* shots, const int count,
+                    CarromEvalOutcome* outcomes)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(startFrame != NULL);
+	MACARON_ASSERT(shots != NULL);
+	MACARON_ASSERT(outcomes != NULL);
+	MACARON_ASSERT(def == NULL || def->workerCount <= MAX_BATCH_WORKERS);
+
+	if (def == NULL || startFrame == NULL || shots == NULL || outcomes == NULL || count <= 0)
+	{
+		return 0;
+	}
+
+	const bool hasTaskSystem = def->enqueueTask != NULL && def->finishTask != NULL;
+
+	// a clamped worker count would let the task system index states that do not exist
+	if (hasTaskSystem && def->workerCount > MAX_BATCH_WORKERS)
+	{
+		return 0;
+	}
+
+	int workerCount = hasTaskSystem ? def->workerCount : 1;
+	workerCount = workerCount < 1 ? 1 : workerCount;
+
+	// Box2D worlds must be created on the calling thread, each worker steps its own world single threaded
+	CarromGameDef gameDef = def->gameDef;
+	gameDef.worldDef.workerCount = 1;
+
+	CarromGameState* pooledStates[MAX_BATCH_WORKERS];
+	bool owned[MAX_BATCH_WORKERS];
+
+	// states missing from the pool are created for this call only, sized to the workers
+	CarromGameState* ownedStates = NULL;
+	for (int i = 0; i < workerCount; i++)
+	{
+		CarromGameState* state = def->statePool != NULL ? CarromGameStatePool_Acquire(def->statePool) : NULL;
+		owned[i] = state == NULL;
+		if (owned[i])
+		{
+			if (ownedStates == NULL)
+			{
+				ownedStates = malloc(sizeof(CarromGameState) * (size_t)workerCount);
+			}
+			if (ownedStates == NULL)
+			{
+				// nothing is owned yet, only the pooled states go back
+				for (int j = 0; j < i; j++)
+				{
+					CarromGameStatePool_Release(def->statePool, pooledStates[j]);
+				}
+				return 0;
+			}
+			ownedStates[i] = CarromGameState_New(&gameDef);
+			state = &ownedStates[i];
+		}
+		pooledStates[i] = state;
+	}
+
+	CarromBatchContext context = {0};
+	context.states = pooledStates;
+	context.workerCount = workerCount;
+	context.startFrame = startFrame;
+	context.shots = shots;
+	context.outcomes = outcomes;
+	context.count = count;
+	context.maxSteps = def->maxSteps;
+	context.stopDef = def->stopDef;
+
+	// the lanes only know pocket and speed based stop conditions, and only replay the disc engine with fixed frames
+	const CarromEvalStopDef* stopDef = def->stopDef;
+	const CarromWorldDef* worldDef = &def->gameDef.worldDef;
+	const bool lockstep = def->lockstep && worldDef->engine == CarromEngine_Disc && !worldDef->adaptiveStep &&
+	                      (stopDef == NULL || (stopDef->customFcn == NULL && !stopDef->onNoReachableContact));
+
+	CarromTaskCallback* task = lockstep ? CarromBatch_LockstepTask : CarromBatch_Task;
+	const int itemCount = lockstep ? (count + CARROM_LANES - 1) / CARROM_LANES : count;
+
+	if (hasTaskSystem)
+	{
+		void* userTask = def->enqueueTask(task, itemCount, 1, &context, def->userTaskContext);
+		if (userTask != NULL)
+		{
+			def->finishTask(userTask, def->userTaskContext);
+		}
+	}
+	else
+	{
+		task(0, itemCount, 0, &context);
+	}
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		if (owned[i])
+		{
+			CarromGameState_Destroy(&ownedStates[i]);
+		}
+		else
+		{
+			CarromGameStatePool_Release(def->statePool, pooledStates[i]);
+		}
+	}
+
+	free(ownedStates);
+
+	return count;
+}
@@ -49,6 +49,7 @@ CarromObjectPhysicsDef CarromPuckPhysicsDefFromTomlTable(const toml_table_t* tab
 	{
 		error("cannot read puck.shapeDensity", "");
 	}
+	const toml_datum_t puckRestSpeed = toml_double_in(table, "restSpeed");
 
 	puckPhysicsDef.radius = (float)puckRadius.u.d;
 	puckPhysicsDef.gap = puckGap.ok ? (float)puckGap.u.d : 0.0f;
@@ -57,6 +58,7 @@ CarromObjectPhysicsDef CarromPuckPhysicsDefFromTomlTable(const toml_table_t* tab
 	puckPhysicsDef.shapeFriction = (float)puckFriction.u.d;
 	puckPhysicsDef.shapeRestitution = (float)puckRestitution.u.d;
 	puckPhysicsDef.shapeDensity = (float)puckDensity.u.d;
+	puckPhysicsDef.restSpeed = puckRestSpeed.ok ? (float)puckRestSpeed.u.d : CarromDefaultPuckPhysicsDef().restSpeed;
 
 	return puckPhysicsDef;
 
@@ -117,6 +119,12 @@ CarromGameDef CarromGameDefLoadFromToml(const char* path)
 	{
 		error("cannot read world.frameDuration", "");
 	}
+	const toml_datum_t restHoldTime = toml_double_in(world, "restHoldTime");
+	const toml_datum_t adaptiveStep = toml_bool_in(world, "adaptiveStep");
+	const toml_datum_t maxFrameDuration = toml_double_in(world, "maxFrameDuration");
+	const toml_datum_t maxSubStep = toml_int_in(world, "maxSubStep");
+	const toml_datum_t maxSubStepTravel = toml_double_in(world, "maxSubStepTravel");
+	const toml_datum_t engine = toml_string_in(world, "engine");
 
 	worldDef.width = (float)width.u.d;
 	worldDef.height = (float)height.u.d;
@@ -124,6 +132,33 @@ CarromGameDef CarromGameDefLoadFromToml(const char* path)
 	worldDef.subStep = (int32_t)subStep.u.i;
 	worldDef.disableSleep = disableSleep.ok ? disableSleep.u.b : false;
 	worldDef.frameDuration = (float)frameDuration.u.d;
+	const CarromWorldDef defaultWorldDef = CarromDefaultWorldDef();
+	worldDef.restHoldTime = restHoldTime.ok ? (float)restHoldTime.u.d : defaultWorldDef.restHoldTime;
+	worldDef.adaptiveStep = adaptiveStep.ok ? adaptiveStep.u.b : defaultWorldDef.adaptiveStep;
+	worldDef.maxFrameDuration = maxFrameDuration.ok ? (float)maxFrameDuration.u.d : defaultWorldDef.maxFrameDuration;
+	worldDef.maxSubStep = maxSubStep.ok ? (int32_t)maxSubStep.u.i : defaultWorldDef.maxSubStep;
+	worldDef.maxSubStepTravel = maxSubStepTravel.ok ? (float)maxSubStepTravel.u.d : defaultWorldDef.maxSubStepTravel;
+	worldDef.engine = defaultWorldDef.engine;
+	if (engine.ok)
+	{
+		if (strcmp(engine.u.s, "box2d") == 0)
+		{
+			worldDef.engine = CarromEngine_Box2D;
+		}
+		else if (strcmp(engine.u.s, "disc") == 0)
+		{
+			worldDef.engine = CarromEngine_Disc;
+		}
+		else if (strcmp(engine.u.s, "event") == 0)
+		{
+			worldDef.engine = CarromEngine_Event;
+		}
+		else
+		{
+			error("unknown world.engine - ", engine.u.s);
+		}
+		free(engine.u.s);
+	}
 
 	// puck
 	toml_table_t* puckPhysicsTable = toml_table_in(conf, "puck");
@@ -14,6 +14,12 @@ CarromWorldDef CarromDefaultWorldDef(void)
 	def.subStep = 4;
 	def.disableSleep = false;
 	def.frameDuration = 1.0f / 60;
+	def.restHoldTime = 0.1f;
+	def.adaptiveStep = false;
+	def.maxFrameDuration = 1.0f / 15;
+	def.maxSubStep = 8;
+	def.maxSubStepTravel = 0.5f;
+	def.engine = CarromEngine_Box2D;
 	return def;
 }
 
@@ -27,6 +33,7 @@ CarromObjectPhysicsDef CarromDefaultPuckPhysicsDef(void)
 	def.shapeFriction = 0.0f;
 	def.shapeRestitution = 1.0f;
 	def.shapeDensity = 0.45f;
+	def.restSpeed = 0.05f;
 	return def;
 }
 
@@ -39,6 +46,7 @@ CarromObjectPhysicsDef CarromDefaultStrikerPhysicsDef(void)
 	def.shapeFriction = 0.0f;
 	def.shapeRestitution = 1.0f;
 	def.shapeDensity = 0.5f;
+	def.restSpeed = 0.05f;
 	return def;
 }
 
@@ -71,6 +79,92 @@ CarromGameDef CarromDefaultGameDef(void)
 	return def;
 }
 
+CarromLayoutDef CarromDefaultLayoutDef(void)
+{
+	CarromLayoutDef def = {0};
+	def.clearance = 0.001f;
+	def.maxIterations = 32;
+	def.tolerance = 0.0001f;
+	def.disableOthers = false;
+	return def;
+}
+
+CarromRandomLayoutDef CarromDefaultRandomLayoutDef(void)
+{
+	CarromRandomLayoutDef def = {0};
+	def.gameDef = CarromDefaultGameDef();
+	def.clearance = 0.001f;
+	def.clustering = 0.5f;
+	def.numClusters = 3;
+	def.clusterRadius = 1.0f;
+	def.maxAttempts = 32;
+	return def;
+}
+
+CarromBatchDef CarromDefaultBatchDef(void)
+{
+	CarromBatchDef def = {0};
+	def.gameDef = CarromDefaultGameDef();
+	def.workerCount = 1;
+	def.maxSteps = 0;
+	def.enqueueTask = NULL;
+	def.finishTask = NULL;
+	def.userTaskContext = NULL;
+	def.statePool = NULL;
+	def.stopDef = NULL;
+	def.lockstep = false;
+	return def;
+}
+
+CarromEvalStopDef CarromDefaultEvalStopDef(void)
+{
+	CarromEvalStopDef def = {0};
+	def.onStrikerPocketed = false;
+	def.targetIndex = -1;
+	def.numPucksPocketed = 0;
+	def.minSpeed = 0.0f;
+	def.onNoReachableContact = false;
+	def.customFcn = NULL;
+	def.userData = NULL;
+	return def;
+}
+
+CarromShotGeneratorDef CarromDefaultShotGeneratorDef(void)
+{
+	CarromShotGeneratorDef def = {0};
+	def.tablePos = CarromTablePosition_Bottom;
+	def.baselineSamples = 16;
+	def.power = 150.0f;
+	def.minCutCos = 0.2f;
+	def.puckBanks = true;
+	def.strikerBanks = true;
+	return def;
+}
+
+CarromShotSolverDef CarromDefaultShotSolverDef(void)
+{
+	CarromShotSolverDef def = {0};
+	def.batchDef = CarromDefaultBatchDef();
+	def.tablePos = CarromTablePosition_Bottom;
+	def.offsetMin = 0.0f;
+	def.offsetMax = 0.0f;
+	def.angleMin = -b2_pi / 2;
+	def.angleMax = b2_pi / 2;
+	def.powerMin = 50.0f;
+	def.powerMax = 250.0f;
+	def.offsetSteps = 8;
+	def.angleSteps = 36;
+	def.powerSteps = 4;
+	def.refineRounds = 3;
+	def.refineCells = 8;
+	def.maxEvals = 4096;
+	def.maxMilliseconds = 0.0f;
+	def.prefilter = true;
+	def.pocketScore = 1.0f;
+	def.foulPenalty = 2.0f;
+	return def;
+}
+
 int CarromDefaultPuckPosition(const float radius, const float gap, const int numOfPucks, CarromObjectPositionDef* positions)
 {
 	if (positions == NULL || numOfPucks < PUCK_IDX_COUNT)
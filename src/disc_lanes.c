@@ -0,0 +1,604 @@
+#include "core.h"
+#include "disc_lanes.h"
+#include "disc_world.h"
+#include "geometry.h"
+
+#include <macaron/macaron.h>
+
+void CarromDiscLanes_Init(CarromDiscLanes* lanes, const CarromGameState* state, const CarromFrame* startFrame)
+{
+	*lanes = (CarromDiscLanes){0};
+
+	// same fallback as CarromGameState_UpdateRest, rest speeds off means Box2D sleep
+	const bool sleepRest = state->puckPhysicsDef.restSpeed <= 0.0f && state->strikerPhysicsDef.restSpeed <= 0.0f;
+	lanes->restHoldTime = sleepRest ? DISC_TIME_TO_SLEEP : state->worldDef.restHoldTime;
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (!MACARON_IS_VALID_OBJ_IDX(i))
+		{
+			continue;
+		}
+
+		const CarromObjectPhysicsDef* physicsDef = i == IDX_STRIKER ? &state->strikerPhysicsDef : &state->puckPhysicsDef;
+		const float mass = physicsDef->shapeDensity * b2_pi * physicsDef->radius * physicsDef->radius;
+
+		lanes->radius[i] = physicsDef->radius;
+		lanes->invMass[i] = mass > 0.0f ? 1.0f / mass : 0.0f;
+		lanes->linearDamping[i] = physicsDef->bodyLinearDamping;
+		lanes->restitution[i] = physicsDef->shapeRestitution;
+		lanes->restSpeed[i] = physicsDef->restSpeed > 0.0f && !sleepRest ? physicsDef->restSpeed : DISC_SLEEP_THRESHOLD;
+
+		// the striker is placed per lane
+		const CarromObjectSnapshot* snapshot = &startFrame->snapshots[i];
+		if (i == IDX_STRIKER || snapshot->index != i || !snapshot->enable)
+		{
+			continue;
+		}
+
+		lanes->objectMask |= MACARON_OBJ_BIT(i);
+		lanes->px[i] = CarromSplatW(snapshot->position.x);
+		lanes->py[i] = CarromSplatW(snapshot->position.y);
+		lanes->enabled[i] = CarromBitsToMaskW(0xFFFFFFFFu);
+	}
+
+	lanes->halfWidth = state->worldDef.width / 2;
+	lanes->halfHeight = state->worldDef.height / 2;
+	CarromPocketPositions(&state->worldDef, &state->pocketDef, lanes->pockets);
+	lanes->pocketRadius = state->pocketDef.radius;
+
+	lanes->frameDuration = state->worldDef.frameDuration;
+	lanes->subStep = state->worldDef.subStep > 0 ? state->worldDef.subStep : 1;
+}
+
+void CarromDiscLanes_SetShot(CarromDiscLanes* lanes, const int lane, const b2Vec2 strikerPos, const b2Vec2 force)
+{
+	MACARON_ASSERT(lane >= 0 && lane < CARROM_LANES);
+
+	const CarromFloatW laneMask = CarromBitsToMaskW(1u << lane);
+
+	lanes->objectMask |= MACARON_OBJ_BIT(IDX_STRIKER);
+	lanes->px[IDX_STRIKER] = CarromSetLaneW(lanes->px[IDX_STRIKER], lane, strikerPos.x);
+	lanes->py[IDX_STRIKER] = CarromSetLaneW(lanes->py[IDX_STRIKER], lane, strikerPos.y);
+	lanes->enabled[IDX_STRIKER] = CarromOrW(lanes->enabled[IDX_STRIKER], laneMask);
+	lanes->strikerFx = CarromSetLaneW(lanes->strikerFx, lane, force.x);
+	lanes->strikerFy = CarromSetLaneW(lanes->strikerFy, lane, force.y);
+	lanes->active = CarromOrW(lanes->active, laneMask);
+}
+
+/**
+ * Forces and damping, same order as Box2D velocity integration
+ */
+static void CarromDiscLanes_IntegrateVelocities(CarromDiscLanes* lanes, const float h, const bool applyForce)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW moving = CarromAndW(lanes->enabled[i], lanes->active);
+		const CarromFloatW scale = CarromSplatW(1.0f / (1.0f + h * lanes->linearDamping[i]));
+
+		CarromFloatW vx = lanes->vx[i];
+		CarromFloatW vy = lanes->vy[i];
+		if (applyForce && i == IDX_STRIKER)
+		{
+			const CarromFloatW hInvMass = CarromSplatW(h * lanes->invMass[i]);
+			vx = CarromMulAddW(vx, hInvMass, lanes->strikerFx);
+			vy = CarromMulAddW(vy, hInvMass, lanes->strikerFy);
+		}
+
+		lanes->vx[i] = CarromBlendW(lanes->vx[i], CarromMulW(vx, scale), moving);
+		lanes->vy[i] = CarromBlendW(lanes->vy[i], CarromMulW(vy, scale), moving);
+	}
+}
+
+/**
+ * Restitution mixed like b2MixRestitution, dropped below the Box2D threshold
+ */
+static CarromFloatW CarromDiscLanes_Restitution(const float restitution, const CarromFloatW approachSpeed)
+{
+	const CarromFloatW bounce = CarromLessW(CarromSplatW(DISC_RESTITUTION_THRESHOLD), approachSpeed);
+	return CarromBlendW(CarromZeroW(), CarromSplatW(restitution), bounce);
+}
+
+/**
+ * Disc pairs touching within the sub step, every lane at once
+ *
+ * the impulse is applied at the start of the sub step and positions are corrected back to the time of impact,
+ * so the pair ends the sub step where a contact at that time would leave it
+ */
+static void CarromDiscLanes_SolveDiscs(CarromDiscLanes* lanes, const float h)
+{
+	const CarromFloatW zero = CarromZeroW();
+	const CarromFloatW hW = CarromSplatW(h);
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW activeI = CarromAndW(lanes->enabled[i], lanes->active);
+		if (CarromMaskToBitsW(activeI) == 0)
+		{
+			continue;
+		}
+
+		for (int j = i + 1; j < NUM_OF_OBJECTS; j++)
+		{
+			if ((lanes->objectMask & MACARON_OBJ_BIT(j)) == 0)
+			{
+				continue;
+			}
+
+			const CarromFloatW both = CarromAndW(activeI, lanes->enabled[j]);
+			if (CarromMaskToBitsW(both) == 0)
+			{
+				continue;
+			}
+
+			const float r = lanes->radius[i] + lanes->radius[j];
+			const CarromFloatW dx = CarromSubW(lanes->px[j], lanes->px[i]);
+			const CarromFloatW dy = CarromSubW(lanes->py[j], lanes->py[i]);
+			const CarromFloatW dvx = CarromSubW(lanes->vx[j], lanes->vx[i]);
+			const CarromFloatW dvy = CarromSubW(lanes->vy[j], lanes->vy[i]);
+
+			// time of impact, same quadratic as CarromDiscWorld_DiscTime
+			const CarromFloatW b = CarromMulAddW(CarromMulW(dx, dvx), dy, dvy);
+			const CarromFloatW distanceSquared = CarromMulAddW(CarromMulW(dx, dx), dy, dy);
+			const CarromFloatW c = CarromSubW(distanceSquared, CarromSplatW(r * r));
+			const CarromFloatW a = CarromMulAddW(CarromMulW(dvx, dvx), dvy, dvy);
+			const CarromFloatW discriminant = CarromMulSubW(CarromMulW(b, b), a, c);
+
+			CarromFloatW hit = CarromAndW(both, CarromAndW(CarromLessW(b, zero), CarromLessW(CarromSplatW(-FLT_EPSILON), discriminant)));
+			if (CarromMaskToBitsW(hit) == 0)
+			{
+				continue;
+			}
+
+			const CarromFloatW root = CarromSubW(CarromSqrtW(CarromMaxW(discriminant, zero)), b);
+			const CarromFloatW toi = CarromMaxW(CarromDivW(c, CarromMaxW(root, CarromSplatW(FLT_MIN))), zero);
+			hit = CarromAndW(hit, CarromLessW(toi, hW));
+			if (CarromMaskToBitsW(hit) == 0)
+			{
+				continue;
+			}
+
+			// normal at the time of impact
+			const CarromFloatW cx = CarromMulAddW(dx, dvx, toi);
+			const CarromFloatW cy = CarromMulAddW(dy, dvy, toi);
+			const CarromFloatW length = CarromMaxW(CarromSqrtW(CarromMulAddW(CarromMulW(cx, cx), cy, cy)), CarromSplatW(FLT_MIN));
+			const CarromFloatW nx = CarromDivW(cx, length);
+			const CarromFloatW ny = CarromDivW(cy, length);
+
+			const CarromFloatW vn = CarromMulAddW(CarromMulW(dvx, nx), dvy, ny);
+			hit = CarromAndW(hit, CarromLessW(vn, zero));
+
+			const float invMassSum = lanes->invMass[i] + lanes->invMass[j];
+			if (CarromMaskToBitsW(hit) == 0 || invMassSum == 0.0f)
+			{
+				continue;
+			}
+
+			const float restitution = b2MaxFloat(lanes->restitution[i], lanes->restitution[j]);
+			const CarromFloatW e = CarromDiscLanes_Restitution(restitution, CarromSubW(zero, vn));
+			const CarromFloatW impulse = CarromMulW(CarromMulAddW(CarromSplatW(1.0f), e, CarromSplatW(1.0f)),
+			                                        CarromMulW(vn, CarromSplatW(-1.0f / invMassSum)));
+			const CarromFloatW impulseX = CarromBlendW(zero, CarromMulW(impulse, nx), hit);
+			const CarromFloatW impulseY = CarromBlendW(zero, CarromMulW(impulse, ny), hit);
+
+			const CarromFloatW invMassI = CarromSplatW(lanes->invMass[i]);
+			const CarromFloatW invMassJ = CarromSplatW(lanes->invMass[j]);
+			lanes->vx[i] = CarromMulSubW(lanes->vx[i], impulseX, invMassI);
+			lanes->vy[i] = CarromMulSubW(lanes->vy[i], impulseY, invMassI);
+			lanes->vx[j] = CarromMulAddW(lanes->vx[j], impulseX, invMassJ);
+			lanes->vy[j] = CarromMulAddW(lanes->vy[j], impulseY, invMassJ);
+
+			// p + toi * v + (h - toi) * (v + dv) == p + h * (v + dv) - toi * dv, toi is garbage on missed lanes
+			const CarromFloatW hitToi = CarromBlendW(zero, toi, hit);
+			const CarromFloatW shiftI = CarromMulW(hitToi, invMassI);
+			const CarromFloatW shiftJ = CarromMulW(hitToi, invMassJ);
+			lanes->px[i] = CarromMulAddW(lanes->px[i], impulseX, shiftI);
+			lanes->py[i] = CarromMulAddW(lanes->py[i], impulseY, shiftI);
+			lanes->px[j] = CarromMulSubW(lanes->px[j], impulseX, shiftJ);
+			lanes->py[j] = CarromMulSubW(lanes->py[j], impulseY, shiftJ);
+		}
+	}
+}
+
+/**
+ * One cushion axis of one object, every lane at once
+ */
+static void CarromDiscLanes_SolveCushion(const CarromDiscLanes* lanes, const int i, const float limit, const float h,
+                                         CarromFloatW* p, CarromFloatW* v)
+{
+	const CarromFloatW zero = CarromZeroW();
+	const CarromFloatW moving = CarromAndW(lanes->enabled[i], lanes->active);
+	const CarromFloatW next = CarromMulAddW(*p, *v, CarromSplatW(h));
+
+	const CarromFloatW hitMax = CarromAndW(CarromLessW(zero, *v), CarromLessW(CarromSplatW(limit), next));
+	const CarromFloatW hitMin = CarromAndW(CarromLessW(*v, zero), CarromLessW(next, CarromSplatW(-limit)));
+	const CarromFloatW hit = CarromAndW(moving, CarromOrW(hitMax, hitMin));
+	if (CarromMaskToBitsW(hit) == 0)
+	{
+		return;
+	}
+
+	const CarromFloatW wall = CarromBlendW(CarromSplatW(-limit), CarromSplatW(limit), hitMax);
+	const CarromFloatW speed = CarromMaxW(*v, CarromSubW(zero, *v));
+	const CarromFloatW safeV = CarromBlendW(CarromSplatW(1.0f), *v, hit);
+	const CarromFloatW toi = CarromMaxW(CarromDivW(CarromSubW(wall, *p), safeV), zero);
+
+	const float restitution = b2MaxFloat(lanes->restitution[i], DISC_CUSHION_RESTITUTION);
+	const CarromFloatW e = CarromDiscLanes_Restitution(restitution, speed);
+	const CarromFloatW bounced = CarromSubW(zero, CarromMulW(e, *v));
+	const CarromFloatW dv = CarromBlendW(zero, CarromSubW(bounced, *v), hit);
+
+	*v = CarromAddW(*v, dv);
+	*p = CarromMulSubW(*p, dv, toi);
+}
+
+static void CarromDiscLanes_SolveCushions(CarromDiscLanes* lanes, const float h)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const float limitX = lanes->halfWidth - lanes->radius[i];
+		const float limitY = lanes->halfHeight - lanes->radius[i];
+		CarromDiscLanes_SolveCushion(lanes, i, limitX, h, &lanes->px[i], &lanes->vx[i]);
+		CarromDiscLanes_SolveCushion(lanes, i, limitY, h, &lanes->py[i], &lanes->vy[i]);
+	}
+}
+
+static void CarromDiscLanes_IntegratePositions(CarromDiscLanes* lanes, const float h)
+{
+	const CarromFloatW hW = CarromSplatW(h);
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW moving = CarromAndW(lanes->enabled[i], lanes->active);
+		lanes->px[i] = CarromBlendW(lanes->px[i], CarromMulAddW(lanes->px[i], lanes->vx[i], hW), moving);
+		lanes->py[i] = CarromBlendW(lanes->py[i], CarromMulAddW(lanes->py[i], lanes->vy[i], hW), moving);
+	}
+}
+
+/**
+ * Push overlapping discs apart and back inside the cushions, every lane at once, same pass as CarromDiscWorld_Project
+ *
+ * pairs are solved once per sub step in index order rather than in time of impact order,
+ * dense clusters may end a step slightly overlapped and this removes it
+ */
+static void CarromDiscLanes_Project(CarromDiscLanes* lanes)
+{
+	const CarromFloatW zero = CarromZeroW();
+	const CarromFloatW one = CarromSplatW(1.0f);
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW activeI = CarromAndW(lanes->enabled[i], lanes->active);
+		if (CarromMaskToBitsW(activeI) == 0)
+		{
+			continue;
+		}
+
+		for (int j = i + 1; j < NUM_OF_OBJECTS; j++)
+		{
+			const float invMassSum = lanes->invMass[i] + lanes->invMass[j];
+			if ((lanes->objectMask & MACARON_OBJ_BIT(j)) == 0 || invMassSum == 0.0f)
+			{
+				continue;
+			}
+
+			const float r = lanes->radius[i] + lanes->radius[j];
+			const CarromFloatW dx = CarromSubW(lanes->px[j], lanes->px[i]);
+			const CarromFloatW dy = CarromSubW(lanes->py[j], lanes->py[i]);
+			const CarromFloatW dd = CarromMulAddW(CarromMulW(dx, dx), dy, dy);
+
+			const CarromFloatW overlap = CarromAndW(CarromAndW(activeI, lanes->enabled[j]), CarromLessW(dd, CarromSplatW(r * r)));
+			if (CarromMaskToBitsW(overlap) == 0)
+			{
+				continue;
+			}
+
+			// coincident centers are pushed along x
+			const CarromFloatW length = CarromSqrtW(dd);
+			const CarromFloatW apart = CarromLessW(zero, length);
+			const CarromFloatW safeLength = CarromBlendW(one, length, apart);
+			const CarromFloatW nx = CarromBlendW(one, CarromDivW(dx, safeLength), apart);
+			const CarromFloatW ny = CarromBlendW(zero, CarromDivW(dy, safeLength), apart);
+
+			const CarromFloatW push = CarromBlendW(zero, CarromMulW(CarromSubW(CarromSplatW(r), length), CarromSplatW(1.0f / invMassSum)), overlap);
+			const CarromFloatW pushI = CarromMulW(push, CarromSplatW(lanes->invMass[i]));
+			const CarromFloatW pushJ = CarromMulW(push, CarromSplatW(lanes->invMass[j]));
+			lanes->px[i] = CarromMulSubW(lanes->px[i], pushI, nx);
+			lanes->py[i] = CarromMulSubW(lanes->py[i], pushI, ny);
+			lanes->px[j] = CarromMulAddW(lanes->px[j], pushJ, nx);
+			lanes->py[j] = CarromMulAddW(lanes->py[j], pushJ, ny);
+		}
+
+		const CarromFloatW limitX = CarromSplatW(lanes->halfWidth - lanes->radius[i]);
+		const CarromFloatW limitY = CarromSplatW(lanes->halfHeight - lanes->radius[i]);
+		const CarromFloatW minX = CarromSubW(zero, limitX);
+		const CarromFloatW minY = CarromSubW(zero, limitY);
+		CarromFloatW x = lanes->px[i];
+		CarromFloatW y = lanes->py[i];
+		x = CarromBlendW(x, limitX, CarromLessW(limitX, x));
+		x = CarromBlendW(x, minX, CarromLessW(x, minX));
+		y = CarromBlendW(y, limitY, CarromLessW(limitY, y));
+		y = CarromBlendW(y, minY, CarromLessW(y, minY));
+		lanes->px[i] = CarromBlendW(lanes->px[i], x, activeI);
+		lanes->py[i] = CarromBlendW(lanes->py[i], y, activeI);
+	}
+}
+
+/**
+ * Objects overlapping a pocket at the end of the step, recorded in the outcome of their lane and disabled
+ */
+static void CarromDiscLanes_CollectPocketed(CarromDiscLanes* lanes, CarromEvalOutcome* outcomes)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const float reach = lanes->pocketRadius + lanes->radius[i];
+		const CarromFloatW reachSquared = CarromSplatW(reach * reach);
+
+		CarromFloatW inPocket = CarromZeroW();
+		for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+		{
+			const CarromFloatW dx = CarromSubW(lanes->px[i], CarromSplatW(lanes->pockets[j].x));
+			const CarromFloatW dy = CarromSubW(lanes->py[i], CarromSplatW(lanes->pockets[j].y));
+			inPocket = CarromOrW(inPocket, CarromLessW(CarromMulAddW(CarromMulW(dx, dx), dy, dy), reachSquared));
+		}
+
+		const CarromFloatW pocketed = CarromAndW(CarromAndW(lanes->enabled[i], lanes->active), inPocket);
+		uint32_t bits = CarromMaskToBitsW(pocketed);
+		if (bits == 0)
+		{
+			continue;
+		}
+
+		lanes->enabled[i] = CarromAndNotW(lanes->enabled[i], pocketed);
+
+		// rare, resolve the pocket lane by lane
+		for (int lane = 0; bits != 0; lane++, bits >>= 1)
+		{
+			CarromEvalOutcome* outcome = &outcomes[lane];
+			if ((bits & 1u) == 0 || outcome->pucksHitPocket >= NUM_OF_OBJECTS)
+			{
+				continue;
+			}
+
+			const b2Vec2 position = {CarromGetLaneW(lanes->px[i], lane), CarromGetLaneW(lanes->py[i], lane)};
+			int8_t pocket = -1;
+			for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+			{
+				if (b2DistanceSquared(position, lanes->pockets[j]) < reach * reach)
+				{
+					pocket = (int8_t)j;
+					break;
+				}
+			}
+
+			if (i == IDX_STRIKER)
+			{
+				outcome->strikerHitPocket = true;
+			}
+
+			outcome->pocketedOrder[outcome->pucksHitPocket] = (int8_t)i;
+			outcome->pocketedPocket[outcome->pucksHitPocket] = pocket;
+			outcome->pucksHitPocket++;
+		}
+	}
+}
+
+/**
+ * Rest timers, same rules as CarromGameState_UpdateRest
+ *
+ * @return lanes where something still moves, one bit per lane
+ */
+static uint32_t CarromDiscLanes_UpdateRest(CarromDiscLanes* lanes, const float dt)
+{
+	const CarromFloatW holdTime = CarromSplatW(lanes->restHoldTime);
+	CarromFloatW moving = CarromZeroW();
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW enabled = CarromAndW(lanes->enabled[i], lanes->active);
+		const CarromFloatW speedSquared = CarromMulAddW(CarromMulW(lanes->vx[i], lanes->vx[i]), lanes->vy[i], lanes->vy[i]);
+		const CarromFloatW slow = CarromLessW(speedSquared, CarromSplatW(lanes->restSpeed[i] * lanes->restSpeed[i]));
+
+		const CarromFloatW restTime = CarromBlendW(CarromZeroW(), CarromAddW(lanes->restTime[i], CarromSplatW(dt)), slow);
+		lanes->restTime[i] = CarromBlendW(holdTime, restTime, enabled);
+		moving = CarromOrW(moving, CarromAndW(enabled, CarromLessW(lanes->restTime[i], holdTime)));
+	}
+
+	return CarromMaskToBitsW(moving);
+}
+
+/**
+ * @return lanes where every enabled object is slower than speed, one bit per lane
+ */
+static uint32_t CarromDiscLanes_SlowerThan(const CarromDiscLanes* lanes, const float speed)
+{
+	CarromFloatW maxSpeedSquared = CarromZeroW();
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const CarromFloatW speedSquared = CarromMulAddW(CarromMulW(lanes->vx[i], lanes->vx[i]), lanes->vy[i], lanes->vy[i]);
+		maxSpeedSquared = CarromMaxW(maxSpeedSquared, CarromBlendW(CarromZeroW(), speedSquared, lanes->enabled[i]));
+	}
+
+	return CarromMaskToBitsW(CarromLessW(maxSpeedSquared, CarromSplatW(speed * speed)));
+}
+
+/**
+ * Pocket based stop conditions of one lane, mirrors CarromGameState_CheckStop
+ */
+static bool CarromDiscLanes_CheckStop(const CarromEvalStopDef* stopDef, CarromEvalOutcome* outcome, const int firstPocketed)
+{
+	for (int i = firstPocketed; i < outcome->pucksHitPocket; i++)
+	{
+		const int8_t objectIndex = outcome->pocketedOrder[i];
+		if (stopDef->onStrikerPocketed && objectIndex == IDX_STRIKER)
+		{
+			outcome->stopReason = CarromEvalStopReason_StrikerPocketed;
+			return true;
+		}
+		if (stopDef->targetIndex >= 0 && objectIndex == stopDef->targetIndex)
+		{
+			outcome->stopReason = CarromEvalStopReason_TargetPocketed;
+			return true;
+		}
+	}
+
+	if (stopDef->numPucksPocketed > 0 && firstPocketed < outcome->pucksHitPocket)
+	{
+		const int numPucks = outcome->pucksHitPocket - (outcome->strikerHitPocket ? 1 : 0);
+		if (numPucks >= stopDef->numPucksPocketed)
+		{
+			outcome->stopReason = CarromEvalStopReason_PucksPocketed;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CarromDiscLanes_Eval(CarromDiscLanes* lanes, const int maxSteps, const CarromEvalStopDef* stopDef,
+                          CarromEvalOutcome* outcomes)
+{
+	MACARON_ASSERT(maxSteps >= 0 && maxSteps <= INT16_MAX);
+	MACARON_ASSERT(stopDef == NULL || (stopDef->customFcn == NULL && !stopDef->onNoReachableContact));
+
+	const uint32_t usedBits = CarromMaskToBitsW(lanes->active);
+	for (int lane = 0; lane < CARROM_LANES; lane++)
+	{
+		if ((usedBits & (1u << lane)) != 0)
+		{
+			outcomes[lane] = (CarromEvalOutcome){0};
+			outcomes[lane].stopReason = CarromEvalStopReason_MaxSteps;
+		}
+	}
+
+	const int caps = maxSteps == 0 ? MAX_FRAME_CAPACITY : maxSteps;
+	const float dt = lanes->frameDuration;
+	const float h = dt / (float)lanes->subStep;
+
+	uint32_t activeBits = usedBits;
+	for (int step = 0; step < caps && activeBits != 0; step++)
+	{
+		for (int s = 0; s < lanes->subStep; s++)
+		{
+			CarromDiscLanes_IntegrateVelocities(lanes, h, step == 0);
+			CarromDiscLanes_SolveDiscs(lanes, h);
+			CarromDiscLanes_SolveCushions(lanes, h);
+			CarromDiscLanes_IntegratePositions(lanes, h);
+		}
+		CarromDiscLanes_Project(lanes);
+
+		int firstPocketed[CARROM_LANES];
+		for (int lane = 0; lane < CARROM_LANES; lane++)
+		{
+			firstPocketed[lane] = outcomes[lane].pucksHitPocket;
+			if ((activeBits & (1u << lane)) != 0)
+			{
+				outcomes[lane].numFrames++;
+				outcomes[lane].time += dt;
+			}
+		}
+
+		CarromDiscLanes_CollectPocketed(lanes, outcomes);
+
+		const uint32_t movingBits = CarromDiscLanes_UpdateRest(lanes, dt);
+		const uint32_t slowBits = stopDef != NULL && stopDef->minSpeed > 0.0f
+			                          ? CarromDiscLanes_SlowerThan(lanes, stopDef->minSpeed)
+			                          : 0;
+
+		uint32_t finishedBits = 0;
+		for (int lane = 0; lane < CARROM_LANES; lane++)
+		{
+			const uint32_t bit = 1u << lane;
+			if ((activeBits & bit) == 0)
+			{
+				continue;
+			}
+
+			CarromEvalOutcome* outcome = &outcomes[lane];
+			if ((movingBits & bit) == 0)
+			{
+				// at rest, the striker leaves the table like in CarromGameState_EvalOutcomeUntil
+				outcome->stopReason = CarromEvalStopReason_Rest;
+				lanes->enabled[IDX_STRIKER] = CarromAndNotW(lanes->enabled[IDX_STRIKER], CarromBitsToMaskW(bit));
+				finishedBits |= bit;
+			}
+			else if (stopDef != NULL && CarromDiscLanes_CheckStop(stopDef, outcome, firstPocketed[lane]))
+			{
+				finishedBits |= bit;
+			}
+			else if ((slowBits & bit) != 0)
+			{
+				outcome->stopReason = CarromEvalStopReason_MinSpeed;
+				finishedBits |= bit;
+			}
+		}
+
+		// finished lanes are frozen
+		activeBits &= ~finishedBits;
+		lanes->active = CarromBitsToMaskW(activeBits);
+	}
+
+	// read positions once per lane
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((lanes->objectMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		const uint32_t enabledBits = CarromMaskToBitsW(lanes->enabled[i]);
+		float px[CARROM_LANES];
+		float py[CARROM_LANES];
+		CarromStoreW(px, lanes->px[i]);
+		CarromStoreW(py, lanes->py[i]);
+
+		for (int lane = 0; lane < CARROM_LANES; lane++)
+		{
+			if ((usedBits & (1u << lane)) != 0)
+			{
+				outcomes[lane].enables[i] = (enabledBits & (1u << lane)) != 0;
+				outcomes[lane].positions[i] = (b2Vec2){px[lane], py[lane]};
+			}
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "simd.h"
+
+#include <macaron/types.h>
+
+// Lockstep disc engine, lane l of every vector simulates the l-th shot of a group
+typedef struct CarromDiscLanes
+{
+	// positions
+	CarromFloatW px[NUM_OF_OBJECTS];
+	CarromFloatW py[NUM_OF_OBJECTS];
+	// linear velocities
+	CarromFloatW vx[NUM_OF_OBJECTS];
+	CarromFloatW vy[NUM_OF_OBJECTS];
+	// lanes where the object is enabled, as a mask
+	CarromFloatW enabled[NUM_OF_OBJECTS];
+	// time spent below the rest speed
+	CarromFloatW restTime[NUM_OF_OBJECTS];
+	// striker force, applied during the first step
+	CarromFloatW strikerFx;
+	CarromFloatW strikerFy;
+	// lanes still simulated, as a mask
+	CarromFloatW active;
+
+	// objects enabled in at least one lane
+	uint32_t objectMask;
+
+	// per object physics, shared by every lane
+	float radius[NUM_OF_OBJECTS];
+	float invMass[NUM_OF_OBJECTS];
+	float linearDamping[NUM_OF_OBJECTS];
+	float restitution[NUM_OF_OBJECTS];
+	float restSpeed[NUM_OF_OBJECTS];
+
+	// table
+	float halfWidth;
+	float halfHeight;
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	float pocketRadius;
+
+	// stepping
+	float frameDuration;
+	int32_t subStep;
+	float restHoldTime;
+
+} CarromDiscLanes;
+
+/**
+ * Load the physics of the game state and the pucks of the starting frame into every lane,
+ * no lane is active until CarromDiscLanes_SetShot
+ */
+void CarromDiscLanes_Init(CarromDiscLanes* lanes, const CarromGameState* state, const CarromFrame* startFrame);
+
+/**
+ * Activate a lane with the striker placed at strikerPos and struck with force
+ */
+void CarromDiscLanes_SetShot(CarromDiscLanes* lanes, int lane, b2Vec2 strikerPos, b2Vec2 force);
+
+/**
+ * Step every active lane together until each one rests or stops, same semantics as CarromGameState_EvalOutcomeUntil
+ *
+ * @param lanes lanes to evaluate
+ * @param maxSteps maximum steps allowed, 0 means MAX_FRAME_CAPACITY
+ * @param stopDef stop conditions, onNoReachableContact and customFcn are not supported
+ * @param outcomes output outcomes, CARROM_LANES entries, only active lanes are written
+ */
+void CarromDiscLanes_Eval(CarromDiscLanes* lanes, int maxSteps, const CarromEvalStopDef* stopDef,
+                          CarromEvalOutcome* outcomes);
@@ -0,0 +1,919 @@
+#include "core.h"
+#include "disc_world.h"
+#include "geometry.h"
+
+#include <float.h>
+#include <stdlib.h>
+
+// events resolved per sub step before the remaining time is integrated blindly
+#define DISC_MAX_TOI_ITERATIONS (4 * NUM_OF_OBJECTS)
+
+// events resolved per step in event driven mode, a break shot needs a few dozen
+#define DISC_MAX_EVENTS (16 * NUM_OF_OBJECTS)
+
+// conservative advancement for pairs with different damping
+#define DISC_MAX_ADVANCE_ITERATIONS 32
+#define DISC_ADVANCE_TOLERANCE (0.1f * DISC_LINEAR_SLOP)
+
+typedef enum CarromDiscEventType
+{
+	CarromDiscEvent_None,
+	CarromDiscEvent_Disc,
+	CarromDiscEvent_CushionX,
+	CarromDiscEvent_CushionY,
+	CarromDiscEvent_Pocket,
+	CarromDiscEvent_Sleep,
+} CarromDiscEventType;
+
+typedef struct CarromDiscEvent
+{
+	CarromDiscEventType type;
+	float time;
+	int a;
+	int b;
+} CarromDiscEvent;
+
+static void CarromDiscWorld_InitDisc(CarromDiscWorld* world, const int index, const CarromObjectPhysicsDef* physicsDef)
+{
+	const float mass = physicsDef->shapeDensity * b2_pi * physicsDef->radius * physicsDef->radius;
+
+	world->existMask |= MACARON_OBJ_BIT(index);
+	world->radius[index] = physicsDef->radius;
+	world->invMass[index] = mass > 0.0f ? 1.0f / mass : 0.0f;
+	world->linearDamping[index] = physicsDef->bodyLinearDamping;
+	world->angularDamping[index] = physicsDef->bodyAngularDamping;
+	world->restitution[index] = physicsDef->shapeRestitution;
+}
+
+CarromDiscWorld* CarromDiscWorld_Create(const CarromWorldDef* worldDef, const CarromPocketDef* pocketDef,
+                                        const CarromObjectPhysicsDef* puckPhysicsDef,
+                                        const CarromObjectPhysicsDef* strikerPhysicsDef)
+{
+	CarromDiscWorld* world = calloc(1, sizeof(CarromDiscWorld));
+	if (world == NULL)
+	{
+		return NULL;
+	}
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (i == IDX_STRIKER)
+		{
+			CarromDiscWorld_InitDisc(world, i, strikerPhysicsDef);
+		}
+		else if (MACARON_IS_VALID_PUCK_IDX(i))
+		{
+			CarromDiscWorld_InitDisc(world, i, puckPhysicsDef);
+		}
+	}
+
+	world->halfWidth = worldDef->width / 2;
+	world->halfHeight = worldDef->height / 2;
+	CarromPocketPositions(worldDef, pocketDef, world->pockets);
+	world->pocketRadius = pocketDef->radius;
+	world->enableSleep = !worldDef->disableSleep;
+	world->eventDriven = worldDef->engine == CarromEngine_Event;
+
+	return world;
+}
+
+void CarromDiscWorld_Destroy(CarromDiscWorld* world)
+{
+	free(world);
+}
+
+void CarromDiscWorld_SetEnabled(CarromDiscWorld* world, const int index, const bool enable)
+{
+	const uint32_t bit = MACARON_OBJ_BIT(index);
+	if ((world->existMask & bit) == 0)
+	{
+		return;
+	}
+
+	if (enable)
+	{
+		world->enableMask |= bit;
+		world->awakeMask |= bit;
+		world->sleepTime[index] = 0.0f;
+	}
+	else
+	{
+		world->enableMask &= ~bit;
+		world->awakeMask &= ~bit;
+	}
+
+	// contacts and pocket overlaps start over, like a body re-added to the broadphase
+	world->inPocketMask &= ~bit;
+	world->touching[index] = 0;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		world->touching[i] &= ~bit;
+	}
+}
+
+void CarromDiscWorld_SetAwake(CarromDiscWorld* world, const int index, const bool awake)
+{
+	const uint32_t bit = MACARON_OBJ_BIT(index);
+	if ((world->enableMask & bit) == 0)
+	{
+		return;
+	}
+
+	world->sleepTime[index] = 0.0f;
+	if (awake)
+	{
+		world->awakeMask |= bit;
+		return;
+	}
+
+	world->awakeMask &= ~bit;
+	world->vx[index] = 0.0f;
+	world->vy[index] = 0.0f;
+	world->angularVelocity[index] = 0.0f;
+}
+
+static void CarromDiscWorld_AddContact(CarromDiscWorld* world, const int a, const int b)
+{
+	const uint32_t bit = b == IDX_WALL ? DISC_CUSHION_BIT : MACARON_OBJ_BIT(b);
+	if ((world->touching[a] & bit) != 0)
+	{
+		return;
+	}
+
+	world->touching[a] |= bit;
+	if (b != IDX_WALL)
+	{
+		world->touching[b] |= MACARON_OBJ_BIT(a);
+	}
+
+	if (world->numContacts < DISC_MAX_CONTACT_EVENTS)
+	{
+		world->contactA[world->numContacts] = (int8_t)a;
+		world->contactB[world->numContacts] = (int8_t)b;
+		world->numContacts++;
+	}
+}
+
+static void CarromDiscWorld_AddPocketed(CarromDiscWorld* world, const int index, const int pocket)
+{
+	const uint32_t bit = MACARON_OBJ_BIT(index);
+	if ((world->inPocketMask & bit) != 0)
+	{
+		return;
+	}
+
+	world->inPocketMask |= bit;
+	world->pocketedObjects[world->numPocketed] = (int8_t)index;
+	world->pocketedPockets[world->numPocketed] = (int8_t)pocket;
+	world->numPocketed++;
+}
+
+/**
+ * Time until two discs touch, relative motion is linear within a sub step
+ *
+ * @return FLT_MAX if they do not approach each other
+ */
+static float CarromDiscWorld_DiscTime(const CarromDiscWorld* world, const int i, const int j)
+{
+	const float dx = world->px[j] - world->px[i];
+	const float dy = world->py[j] - world->py[i];
+	const float dvx = world->vx[j] - world->vx[i];
+	const float dvy = world->vy[j] - world->vy[i];
+
+	const float b = dx * dvx + dy * dvy;
+	if (b >= 0.0f)
+	{
+		return FLT_MAX;
+	}
+
+	const float r = world->radius[i] + world->radius[j];
+	const float c = dx * dx + dy * dy - r * r;
+	if (c <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	const float a = dvx * dvx + dvy * dvy;
+	const float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+	{
+		return FLT_MAX;
+	}
+
+	return c / (-b + sqrtf(discriminant));
+}
+
+/**
+ * Time until a disc touches a cushion along one axis
+ */
+static float CarromDiscWorld_CushionTime(const float p, const float v, const float limit)
+{
+	if (v > 0.0f)
+	{
+		return p >= limit ? 0.0f : (limit - p) / v;
+	}
+	if (v < 0.0f)
+	{
+		return p <= -limit ? 0.0f : (-limit - p) / v;
+	}
+
+	return FLT_MAX;
+}
+
+static float CarromDiscWorld_Restitution(const float restitution, const float approachSpeed)
+{
+	return approachSpeed > DISC_RESTITUTION_THRESHOLD ? restitution : 0.0f;
+}
+
+static void CarromDiscWorld_SolveDisc(CarromDiscWorld* world, const int i, const int j)
+{
+	const float dx = world->px[j] - world->px[i];
+	const float dy = world->py[j] - world->py[i];
+	const float length = sqrtf(dx * dx + dy * dy);
+	const float nx = length > 0.0f ? dx / length : 1.0f;
+	const float ny = length > 0.0f ? dy / length : 0.0f;
+
+	const float vn = (world->vx[j] - world->vx[i]) * nx + (world->vy[j] - world->vy[i]) * ny;
+	if (vn >= 0.0f)
+	{
+		return;
+	}
+
+	// mixed like b2MixRestitution
+	const float restitution = CarromDiscWorld_Restitution(b2MaxFloat(world->restitution[i], world->restitution[j]), -vn);
+	const float invMassSum = world->invMass[i] + world->invMass[j];
+	if (invMassSum == 0.0f)
+	{
+		return;
+	}
+
+	const float impulse = -(1.0f + restitution) * vn / invMassSum;
+	world->vx[i] -= impulse * world->invMass[i] * nx;
+	world->vy[i] -= impulse * world->invMass[i] * ny;
+	world->vx[j] += impulse * world->invMass[j] * nx;
+	world->vy[j] += impulse * world->invMass[j] * ny;
+
+	// a hit body wakes up
+	world->awakeMask |= MACARON_OBJ_BIT(i) | MACARON_OBJ_BIT(j);
+	world->sleepTime[i] = 0.0f;
+	world->sleepTime[j] = 0.0f;
+
+	CarromDiscWorld_AddContact(world, i, j);
+}
+
+static void CarromDiscWorld_SolveCushion(CarromDiscWorld* world, const int i, float* v)
+{
+	const float restitution = b2MaxFloat(world->restitution[i], DISC_CUSHION_RESTITUTION);
+	*v = -CarromDiscWorld_Restitution(restitution, b2AbsFloat(*v)) * *v;
+
+	CarromDiscWorld_AddContact(world, i, IDX_WALL);
+}
+
+static void CarromDiscWorld_Advance(CarromDiscWorld* world, const float t)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((world->awakeMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		world->px[i] += t * world->vx[i];
+		world->py[i] += t * world->vy[i];
+	}
+}
+
+/**
+ * Move the awake discs through one sub step, stopping at every contact on the way so that nothing tunnels
+ */
+static void CarromDiscWorld_Integrate(CarromDiscWorld* world, const float h)
+{
+	float remaining = h;
+	for (int iteration = 0; iteration < DISC_MAX_TOI_ITERATIONS && remaining > 0.0f; iteration++)
+	{
+		float toi = remaining;
+		CarromDiscEventType eventType = CarromDiscEvent_None;
+		int eventA = -1;
+		int eventB = -1;
+
+		// brute force, 22 discs at most
+		for (int i = 0; i < NUM_OF_OBJECTS; i++)
+		{
+			const uint32_t bitI = MACARON_OBJ_BIT(i);
+			if ((world->enableMask & bitI) == 0)
+			{
+				continue;
+			}
+
+			const bool awakeI = (world->awakeMask & bitI) != 0;
+			if (awakeI)
+			{
+				const float limitX = world->halfWidth - world->radius[i];
+				const float limitY = world->halfHeight - world->radius[i];
+
+				const float tx = CarromDiscWorld_CushionTime(world->px[i], world->vx[i], limitX);
+				if (tx < toi)
+				{
+					toi = tx;
+					eventType = CarromDiscEvent_CushionX;
+					eventA = i;
+				}
+
+				const float ty = CarromDiscWorld_CushionTime(world->py[i], world->vy[i], limitY);
+				if (ty < toi)
+				{
+					toi = ty;
+					eventType = CarromDiscEvent_CushionY;
+					eventA = i;
+				}
+			}
+
+			for (int j = i + 1; j < NUM_OF_OBJECTS; j++)
+			{
+				const uint32_t bitJ = MACARON_OBJ_BIT(j);
+				if ((world->enableMask & bitJ) == 0 || (!awakeI && (world->awakeMask & bitJ) == 0))
+				{
+					continue;
+				}
+
+				const float t = CarromDiscWorld_DiscTime(world, i, j);
+				if (t < toi)
+				{
+					toi = t;
+					eventType = CarromDiscEvent_Disc;
+					eventA = i;
+					eventB = j;
+				}
+			}
+		}
+
+		CarromDiscWorld_Advance(world, toi);
+		remaining -= toi;
+
+		switch (eventType)
+		{
+			case CarromDiscEvent_Disc:
+				CarromDiscWorld_SolveDisc(world, eventA, eventB);
+				break;
+			case CarromDiscEvent_CushionX:
+				CarromDiscWorld_SolveCushion(world, eventA, &world->vx[eventA]);
+				break;
+			case CarromDiscEvent_CushionY:
+				CarromDiscWorld_SolveCushion(world, eventA, &world->vy[eventA]);
+				break;
+			default:
+				return;
+		}
+	}
+
+	if (remaining > 0.0f)
+	{
+		CarromDiscWorld_Advance(world, remaining);
+	}
+}
+
+/**
+ * Push overlapping discs apart and back inside the cushions, float drift only
+ */
+static void CarromDiscWorld_Project(CarromDiscWorld* world)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((world->enableMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		for (int j = i + 1; j < NUM_OF_OBJECTS; j++)
+		{
+			if ((world->enableMask & MACARON_OBJ_BIT(j)) == 0)
+			{
+				continue;
+			}
+
+			const float dx = world->px[j] - world->px[i];
+			const float dy = world->py[j] - world->py[i];
+			const float r = world->radius[i] + world->radius[j];
+			const float dd = dx * dx + dy * dy;
+			const float invMassSum = world->invMass[i] + world->invMass[j];
+			if (dd >= r * r || invMassSum == 0.0f)
+			{
+				continue;
+			}
+
+			const float length = sqrtf(dd);
+			const float nx = length > 0.0f ? dx / length : 1.0f;
+			const float ny = length > 0.0f ? dy / length : 0.0f;
+			const float push = (r - length) / invMassSum;
+
+			world->px[i] -= push * world->invMass[i] * nx;
+			world->py[i] -= push * world->invMass[i] * ny;
+			world->px[j] += push * world->invMass[j] * nx;
+			world->py[j] += push * world->invMass[j] * ny;
+		}
+
+		const float limitX = world->halfWidth - world->radius[i];
+		const float limitY = world->halfHeight - world->radius[i];
+		world->px[i] = b2ClampFloat(world->px[i], -limitX, limitX);
+		world->py[i] = b2ClampFloat(world->py[i], -limitY, limitY);
+	}
+}
+
+/**
+ * Refresh touching flags and pocket overlaps at the end of a step
+ */
+static void CarromDiscWorld_UpdateContacts(CarromDiscWorld* world)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const uint32_t bitI = MACARON_OBJ_BIT(i);
+		if ((world->enableMask & bitI) == 0)
+		{
+			continue;
+		}
+
+		const float x = world->px[i];
+		const float y = world->py[i];
+		const float r = world->radius[i];
+
+		// separated pairs may begin touching again
+		uint32_t touching = world->touching[i];
+		for (int j = 0; j < NUM_OF_OBJECTS; j++)
+		{
+			const uint32_t bitJ = MACARON_OBJ_BIT(j);
+			if ((touching & bitJ) == 0)
+			{
+				continue;
+			}
+
+			const float dx = world->px[j] - x;
+			const float dy = world->py[j] - y;
+			const float reach = r + world->radius[j] + DISC_LINEAR_SLOP;
+			if ((world->enableMask & bitJ) == 0 || dx * dx + dy * dy > reach * reach)
+			{
+				touching &= ~bitJ;
+			}
+		}
+		if ((touching & DISC_CUSHION_BIT) != 0 && b2AbsFloat(x) < world->halfWidth - r - DISC_LINEAR_SLOP &&
+		    b2AbsFloat(y) < world->halfHeight - r - DISC_LINEAR_SLOP)
+		{
+			touching &= ~DISC_CUSHION_BIT;
+		}
+		world->touching[i] = touching;
+
+		// pocket sensors report overlaps once
+		int pocket = -1;
+		for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+		{
+			const float dx = world->pockets[j].x - x;
+			const float dy = world->pockets[j].y - y;
+			const float reach = world->pocketRadius + r;
+			if (dx * dx + dy * dy < reach * reach)
+			{
+				pocket = j;
+				break;
+			}
+		}
+
+		if (pocket < 0)
+		{
+			world->inPocketMask &= ~bitI;
+		}
+		else
+		{
+			CarromDiscWorld_AddPocketed(world, i, pocket);
+		}
+	}
+}
+
+static void CarromDiscWorld_UpdateSleep(CarromDiscWorld* world, const float dt)
+{
+	if (!world->enableSleep)
+	{
+		return;
+	}
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const uint32_t bit = MACARON_OBJ_BIT(i);
+		if ((world->awakeMask & bit) == 0)
+		{
+			continue;
+		}
+
+		const float speedSquared = world->vx[i] * world->vx[i] + world->vy[i] * world->vy[i];
+		const float angularSpeed = b2AbsFloat(world->angularVelocity[i]) * world->radius[i];
+		if (speedSquared > DISC_SLEEP_THRESHOLD * DISC_SLEEP_THRESHOLD || angularSpeed > DISC_SLEEP_THRESHOLD)
+		{
+			world->sleepTime[i] = 0.0f;
+			continue;
+		}
+
+		world->sleepTime[i] += dt;
+		if (world->sleepTime[i] >= DISC_TIME_TO_SLEEP)
+		{
+			CarromDiscWorld_SetAwake(world, i, false);
+		}
+	}
+}
+
+/**
+ * Distance factor of the closed form damped motion, a disc launched at v covers v * travel within t
+ */
+static float CarromDiscWorld_Travel(const float damping, const float t)
+{
+	if (damping <= 0.0f)
+	{
+		return t;
+	}
+
+	return (1.0f - expf(-damping * t)) / damping;
+}
+
+/**
+ * Inverse of CarromDiscWorld_Travel
+ *
+ * @return FLT_MAX if damping stops the disc before it covers the distance factor
+ */
+static float CarromDiscWorld_TravelTime(const float damping, const float travel)
+{
+	if (travel == FLT_MAX || damping <= 0.0f)
+	{
+		return travel;
+	}
+
+	const float x = damping * travel;
+	if (x >= 1.0f)
+	{
+		return FLT_MAX;
+	}
+
+	return -log1pf(-x) / damping;
+}
+
+/**
+ * Time until a damped speed falls to the sleep threshold, 0 if it already did
+ */
+static float CarromDiscWorld_DecayTime(const float speed, const float damping)
+{
+	if (speed <= DISC_SLEEP_THRESHOLD)
+	{
+		return 0.0f;
+	}
+	if (damping <= 0.0f)
+	{
+		return FLT_MAX;
+	}
+
+	return logf(speed / DISC_SLEEP_THRESHOLD) / damping;
+}
+
+static float CarromDiscWorld_SleepDecayTime(const CarromDiscWorld* world, const int i)
+{
+	const float speed = sqrtf(world->vx[i] * world->vx[i] + world->vy[i] * world->vy[i]);
+	const float angularSpeed = b2AbsFloat(world->angularVelocity[i]) * world->radius[i];
+	return b2MaxFloat(CarromDiscWorld_DecayTime(speed, world->linearDamping[i]),
+	                  CarromDiscWorld_DecayTime(angularSpeed, world->angularDamping[i]));
+}
+
+/**
+ * Time until two damped discs touch, exact when both share the same damping or one of them rests,
+ * conservative advancement otherwise
+ *
+ * @return FLT_MAX if they do not touch before horizon
+ */
+static float CarromDiscWorld_DiscEventTime(const CarromDiscWorld* world, const int i, const int j, const float horizon)
+{
+	const bool awakeI = (world->awakeMask & MACARON_OBJ_BIT(i)) != 0;
+	const bool awakeJ = (world->awakeMask & MACARON_OBJ_BIT(j)) != 0;
+	const float dampingI = world->linearDamping[i];
+	const float dampingJ = world->linearDamping[j];
+
+	// relative motion is linear in the common distance factor
+	if (!awakeI || !awakeJ || dampingI == dampingJ)
+	{
+		return CarromDiscWorld_TravelTime(awakeI ? dampingI : dampingJ, CarromDiscWorld_DiscTime(world, i, j));
+	}
+
+	const float speedI = sqrtf(world->vx[i] * world->vx[i] + world->vy[i] * world->vy[i]);
+	const float speedJ = sqrtf(world->vx[j] * world->vx[j] + world->vy[j] * world->vy[j]);
+	const float r = world->radius[i] + world->radius[j];
+
+	float t = 0.0f;
+	for (int iteration = 0; iteration < DISC_MAX_ADVANCE_ITERATIONS; iteration++)
+	{
+		const float travelI = CarromDiscWorld_Travel(dampingI, t);
+		const float travelJ = CarromDiscWorld_Travel(dampingJ, t);
+		const float dx = world->px[j] + travelJ * world->vx[j] - world->px[i] - travelI * world->vx[i];
+		const float dy = world->py[j] + travelJ * world->vy[j] - world->py[i] - travelI * world->vy[i];
+		const float gap = sqrtf(dx * dx + dy * dy) - r;
+
+		const float decayI = expf(-dampingI * t);
+		const float decayJ = expf(-dampingJ * t);
+		if (gap <= DISC_ADVANCE_TOLERANCE)
+		{
+			const float vn = (world->vx[j] * decayJ - world->vx[i] * decayI) * dx
+			                 + (world->vy[j] * decayJ - world->vy[i] * decayI) * dy;
+			return vn < 0.0f ? t : FLT_MAX;
+		}
+
+		// speeds only decay, what is left of both paths bounds the approach
+		const float speed = speedI * decayI + speedJ * decayJ;
+		const float reach = speedI * decayI / dampingI + speedJ * decayJ / dampingJ;
+		if (speed <= 0.0f || gap > reach)
+		{
+			return FLT_MAX;
+		}
+
+		t += gap / speed;
+		if (t >= horizon)
+		{
+			return FLT_MAX;
+		}
+	}
+
+	// not converged, the caller only resolves the pair if it really touches
+	return t;
+}
+
+/**
+ * Distance factor until a disc starts overlapping a pocket sensor
+ */
+static float CarromDiscWorld_PocketTravel(const CarromDiscWorld* world, const int i, int* pocket)
+{
+	float travel = FLT_MAX;
+	const float reach = world->pocketRadius + world->radius[i];
+	const float a = world->vx[i] * world->vx[i] + world->vy[i] * world->vy[i];
+
+	for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+	{
+		const float dx = world->px[i] - world->pockets[j].x;
+		const float dy = world->py[i] - world->pockets[j].y;
+		const float c = dx * dx + dy * dy - reach * reach;
+		if (c < 0.0f)
+		{
+			*pocket = j;
+			return 0.0f;
+		}
+
+		const float b = dx * world->vx[i] + dy * world->vy[i];
+		const float discriminant = b * b - a * c;
+		if (b >= 0.0f || discriminant < 0.0f)
+		{
+			continue;
+		}
+
+		const float t = c / (-b + sqrtf(discriminant));
+		if (t < travel)
+		{
+			travel = t;
+			*pocket = j;
+		}
+	}
+
+	return travel;
+}
+
+/**
+ * Earliest event before horizon, every disc follows the closed form damped motion until then
+ */
+static CarromDiscEvent CarromDiscWorld_FindEvent(const CarromDiscWorld* world, const float horizon)
+{
+	CarromDiscEvent event = {CarromDiscEvent_None, horizon, -1, -1};
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const uint32_t bitI = MACARON_OBJ_BIT(i);
+		if ((world->enableMask & bitI) == 0)
+		{
+			continue;
+		}
+
+		const bool awakeI = (world->awakeMask & bitI) != 0;
+		if (awakeI)
+		{
+			const float damping = world->linearDamping[i];
+			const float limitX = world->halfWidth - world->radius[i];
+			const float limitY = world->halfHeight - world->radius[i];
+
+			const float tx = CarromDiscWorld_TravelTime(damping, CarromDiscWorld_CushionTime(world->px[i], world->vx[i], limitX));
+			if (tx < event.time)
+			{
+				event = (CarromDiscEvent){CarromDiscEvent_CushionX, tx, i, -1};
+			}
+
+			const float ty = CarromDiscWorld_TravelTime(damping, CarromDiscWorld_CushionTime(world->py[i], world->vy[i], limitY));
+			if (ty < event.time)
+			{
+				event = (CarromDiscEvent){CarromDiscEvent_CushionY, ty, i, -1};
+			}
+
+			if ((world->inPocketMask & bitI) == 0)
+			{
+				int pocket = -1;
+				const float tp = CarromDiscWorld_TravelTime(damping, CarromDiscWorld_PocketTravel(world, i, &pocket));
+				if (tp < event.time)
+				{
+					event = (CarromDiscEvent){CarromDiscEvent_Pocket, tp, i, pocket};
+				}
+			}
+
+			if (world->enableSleep)
+			{
+				const float decay = CarromDiscWorld_SleepDecayTime(world, i);
+				const float ts = decay > 0.0f ? decay + DISC_TIME_TO_SLEEP : DISC_TIME_TO_SLEEP - world->sleepTime[i];
+				if (ts < event.time)
+				{
+					event = (CarromDiscEvent){CarromDiscEvent_Sleep, b2MaxFloat(ts, 0.0f), i, -1};
+				}
+			}
+		}
+
+		for (int j = i + 1; j < NUM_OF_OBJECTS; j++)
+		{
+			const uint32_t bitJ = MACARON_OBJ_BIT(j);
+			if ((world->enableMask & bitJ) == 0 || (!awakeI && (world->awakeMask & bitJ) == 0))
+			{
+				continue;
+			}
+
+			const float t = CarromDiscWorld_DiscEventTime(world, i, j, event.time);
+			if (t < event.time)
+			{
+				event = (CarromDiscEvent){CarromDiscEvent_Disc, t, i, j};
+			}
+		}
+	}
+
+	return event;
+}
+
+/**
+ * Move the awake discs along their damped paths, no contact happens within t
+ */
+static void CarromDiscWorld_AdvanceDamped(CarromDiscWorld* world, const float t)
+{
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((world->awakeMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		// time spent below the sleep threshold, same bookkeeping as the sub stepped mode
+		const float decay = CarromDiscWorld_SleepDecayTime(world, i);
+		world->sleepTime[i] = decay == 0.0f ? world->sleepTime[i] + t : b2MaxFloat(t - decay, 0.0f);
+
+		const float travel = CarromDiscWorld_Travel(world->linearDamping[i], t);
+		world->px[i] += travel * world->vx[i];
+		world->py[i] += travel * world->vy[i];
+
+		const float linearScale = expf(-world->linearDamping[i] * t);
+		world->vx[i] *= linearScale;
+		world->vy[i] *= linearScale;
+
+		world->angle[i] += CarromDiscWorld_Travel(world->angularDamping[i], t) * world->angularVelocity[i];
+		world->angularVelocity[i] *= expf(-world->angularDamping[i] * t);
+	}
+}
+
+/**
+ * Jump from event to event through the step instead of sub stepping
+ */
+static void CarromDiscWorld_StepEvents(CarromDiscWorld* world, const float dt)
+{
+	// forces act over the whole step, apply them as one impulse
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((world->enableMask & world->awakeMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		world->vx[i] += dt * world->invMass[i] * world->fx[i];
+		world->vy[i] += dt * world->invMass[i] * world->fy[i];
+	}
+
+	float remaining = dt;
+	for (int iteration = 0; iteration < DISC_MAX_EVENTS && remaining > 0.0f; iteration++)
+	{
+		const CarromDiscEvent event = CarromDiscWorld_FindEvent(world, remaining);
+		if (event.type == CarromDiscEvent_None)
+		{
+			break;
+		}
+
+		CarromDiscWorld_AdvanceDamped(world, event.time);
+		remaining -= event.time;
+
+		switch (event.type)
+		{
+			case CarromDiscEvent_Disc:
+			{
+				const float dx = world->px[event.b] - world->px[event.a];
+				const float dy = world->py[event.b] - world->py[event.a];
+				const float reach = world->radius[event.a] + world->radius[event.b] + DISC_LINEAR_SLOP;
+				if (dx * dx + dy * dy <= reach * reach)
+				{
+					CarromDiscWorld_SolveDisc(world, event.a, event.b);
+				}
+				break;
+			}
+			case CarromDiscEvent_CushionX:
+				CarromDiscWorld_SolveCushion(world, event.a, &world->vx[event.a]);
+				break;
+			case CarromDiscEvent_CushionY:
+				CarromDiscWorld_SolveCushion(world, event.a, &world->vy[event.a]);
+				break;
+			case CarromDiscEvent_Pocket:
+				CarromDiscWorld_AddPocketed(world, event.a, event.b);
+				break;
+			case CarromDiscEvent_Sleep:
+				CarromDiscWorld_SetAwake(world, event.a, false);
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (remaining > 0.0f)
+	{
+		CarromDiscWorld_AdvanceDamped(world, remaining);
+	}
+}
+
+float CarromDiscWorld_NextEventTime(const CarromDiscWorld* world, const float horizon)
+{
+	// a pending force changes every path, the next step has to apply it first
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((world->enableMask & world->awakeMask & MACARON_OBJ_BIT(i)) != 0 && (world->fx[i] != 0.0f || world->fy[i] != 0.0f))
+		{
+			return 0.0f;
+		}
+	}
+
+	return CarromDiscWorld_FindEvent(world, horizon).time;
+}
+
+void CarromDiscWorld_Step(CarromDiscWorld* world, const float dt, const int subStep)
+{
+	world->numPocketed = 0;
+	world->numContacts = 0;
+	world->movedMask = world->enableMask & world->awakeMask;
+
+	if (dt <= 0.0f)
+	{
+		return;
+	}
+
+	if (world->eventDriven)
+	{
+		CarromDiscWorld_StepEvents(world, dt);
+	}
+	else
+	{
+		const int count = subStep > 0 ? subStep : 1;
+		const float h = dt / (float)count;
+
+		for (int s = 0; s < count; s++)
+		{
+			// forces and damping, same order as Box2D velocity integration
+			for (int i = 0; i < NUM_OF_OBJECTS; i++)
+			{
+				if ((world->enableMask & world->awakeMask & MACARON_OBJ_BIT(i)) == 0)
+				{
+					continue;
+				}
+
+				const float linearScale = 1.0f / (1.0f + h * world->linearDamping[i]);
+				world->vx[i] = (world->vx[i] + h * world->invMass[i] * world->fx[i]) * linearScale;
+				world->vy[i] = (world->vy[i] + h * world->invMass[i] * world->fy[i]) * linearScale;
+
+				world->angularVelocity[i] *= 1.0f / (1.0f + h * world->angularDamping[i]);
+				world->angle[i] += h * world->angularVelocity[i];
+			}
+
+			CarromDiscWorld_Integrate(world, h);
+		}
+	}
+
+	// forces last one step
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		world->fx[i] = 0.0f;
+		world->fy[i] = 0.0f;
+	}
+
+	CarromDiscWorld_Project(world);
+	CarromDiscWorld_UpdateContacts(world);
+
+	// event driven steps put discs to sleep on the way
+	if (!world->eventDriven)
+	{
+		CarromDiscWorld_UpdateSleep(world, dt);
+	}
+
+	// discs woken up by a hit moved as well
+	world->movedMask |= world->enableMask & world->awakeMask;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <macaron/types.h>
+
+// Box2D defaults the disc engines mirror
+#define DISC_RESTITUTION_THRESHOLD 1.0f
+#define DISC_SLEEP_THRESHOLD 0.05f
+#define DISC_TIME_TO_SLEEP 0.5f
+#define DISC_LINEAR_SLOP 0.005f
+
+// restitution of the cushion chain built by CarromGameState_CreateImpl
+#define DISC_CUSHION_RESTITUTION 1.0f
+
+// contact slot of the cushion in CarromDiscWorld.touching
+#define DISC_CUSHION_BIT MACARON_OBJ_BIT(NUM_OF_OBJECTS)
+
+// most begin touch events kept per step
+#define DISC_MAX_CONTACT_EVENTS 64
+
+// Disc only world, every array is indexed by object index
+typedef struct CarromDiscWorld
+{
+	// objects owning a disc
+	uint32_t existMask;
+	// enabled discs
+	uint32_t enableMask;
+	// awake discs
+	uint32_t awakeMask;
+	// discs simulated during the last step
+	uint32_t movedMask;
+	// discs overlapping a pocket
+	uint32_t inPocketMask;
+
+	// positions
+	float px[NUM_OF_OBJECTS];
+	float py[NUM_OF_OBJECTS];
+	// linear velocities
+	float vx[NUM_OF_OBJECTS];
+	float vy[NUM_OF_OBJECTS];
+	// forces applied during the next step
+	float fx[NUM_OF_OBJECTS];
+	float fy[NUM_OF_OBJECTS];
+	// rotations
+	float angle[NUM_OF_OBJECTS];
+	// angular velocities
+	float angularVelocity[NUM_OF_OBJECTS];
+	// time spent below the sleep threshold
+	float sleepTime[NUM_OF_OBJECTS];
+	// discs and cushion touched at the end of the last step
+	uint32_t touching[NUM_OF_OBJECTS];
+
+	// per disc physics
+	float radius[NUM_OF_OBJECTS];
+	float invMass[NUM_OF_OBJECTS];
+	float linearDamping[NUM_OF_OBJECTS];
+	float angularDamping[NUM_OF_OBJECTS];
+	float restitution[NUM_OF_OBJECTS];
+
+	// table
+	float halfWidth;
+	float halfHeight;
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	float pocketRadius;
+	bool enableSleep;
+	// jump from event to event instead of sub stepping, see CarromEngine_Event
+	bool eventDriven;
+
+	// pocket begin events of the last step
+	int32_t numPocketed;
+	int8_t pocketedObjects[NUM_OF_OBJECTS];
+	int8_t pocketedPockets[NUM_OF_OBJECTS];
+
+	// begin touch events of the last step, IDX_WALL stands for the cushion
+	int32_t numContacts;
+	int8_t contactA[DISC_MAX_CONTACT_EVENTS];
+	int8_t contactB[DISC_MAX_CONTACT_EVENTS];
+
+} CarromDiscWorld;
+
+/**
+ * Create a disc world matching the bodies CarromGameState_CreateImpl builds in Box2D,
+ * pucks start disabled at the origin, the striker starts disabled
+ */
+CarromDiscWorld* CarromDiscWorld_Create(const CarromWorldDef* worldDef, const CarromPocketDef* pocketDef,
+                                        const CarromObjectPhysicsDef* puckPhysicsDef,
+                                        const CarromObjectPhysicsDef* strikerPhysicsDef);
+
+void CarromDiscWorld_Destroy(CarromDiscWorld* world);
+
+/**
+ * Advance the world, same contract as b2World_Step
+ */
+void CarromDiscWorld_Step(CarromDiscWorld* world, float dt, int subStep);
+
+/**
+ * Time until the next contact, pocket or sleep event, discs follow the closed form damped motion until then
+ *
+ * @return horizon if nothing happens before it, 0 if a force is pending
+ */
+float CarromDiscWorld_NextEventTime(const CarromDiscWorld* world, float horizon);
+
+/**
+ * Enable or disable a disc, enabled discs wake up
+ */
+void CarromDiscWorld_SetEnabled(CarromDiscWorld* world, int index, bool enable);
+
+/**
+ * Wake up or put a disc to sleep, sleeping discs lose their velocities
+ */
+void CarromDiscWorld_SetAwake(CarromDiscWorld* world, int index, bool awake);
@@ -0,0 +1,374 @@
+#include "core.h"
+#include "disc_world.h"
+#include "engine.h"
+
+#include <macaron/types.h>
+
+#include <stdlib.h>
+
+static b2BodyId CarromBody_GetId(const CarromGameState* state, const int index)
+{
+	return state->objects[index].bodyId;
+}
+
+bool CarromBody_Exists(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return (state->discWorld->existMask & MACARON_OBJ_BIT(index)) != 0;
+	}
+
+	return !B2_ID_EQUALS(CarromBody_GetId(state, index), b2_nullBodyId);
+}
+
+bool CarromBody_IsEnabled(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return (state->discWorld->enableMask & MACARON_OBJ_BIT(index)) != 0;
+	}
+
+	return (state->mirror->enableMask & MACARON_OBJ_BIT(index)) != 0;
+}
+
+void CarromBody_Enable(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld_SetEnabled(state->discWorld, index, true);
+		return;
+	}
+
+	state->mirror->enableMask |= MACARON_OBJ_BIT(index);
+	b2Body_Enable(CarromBody_GetId(state, index));
+}
+
+void CarromBody_Disable(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld_SetEnabled(state->discWorld, index, false);
+		return;
+	}
+
+	state->mirror->enableMask &= ~MACARON_OBJ_BIT(index);
+	b2Body_Disable(CarromBody_GetId(state, index));
+}
+
+bool CarromBody_IsAwake(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return (state->discWorld->awakeMask & MACARON_OBJ_BIT(index)) != 0;
+	}
+
+	return b2Body_IsAwake(CarromBody_GetId(state, index));
+}
+
+void CarromBody_SetAwake(const CarromGameState* state, const int index, const bool awake)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld_SetAwake(state->discWorld, index, awake);
+		return;
+	}
+
+	b2Body_SetAwake(CarromBody_GetId(state, index), awake);
+}
+
+b2Vec2 CarromBody_GetPosition(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return (b2Vec2){state->discWorld->px[index], state->discWorld->py[index]};
+	}
+
+	return (b2Vec2){state->mirror->px[index], state->mirror->py[index]};
+}
+
+b2Rot CarromBody_GetRotation(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return b2MakeRot(state->discWorld->angle[index]);
+	}
+
+	return b2Body_GetRotation(CarromBody_GetId(state, index));
+}
+
+void CarromBody_SetTransform(const CarromGameState* state, const int index, const b2Vec2 position, const b2Rot rotation)
+{
+	if (state->discWorld != NULL)
+	{
+		state->discWorld->px[index] = position.x;
+		state->discWorld->py[index] = position.y;
+		state->discWorld->angle[index] = b2Rot_GetAngle(rotation);
+		return;
+	}
+
+	state->mirror->px[index] = position.x;
+	state->mirror->py[index] = position.y;
+	b2Body_SetTransform(CarromBody_GetId(state, index), position, rotation);
+}
+
+b2Vec2 CarromBody_GetLinearVelocity(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return (b2Vec2){state->discWorld->vx[index], state->discWorld->vy[index]};
+	}
+
+	return b2Body_GetLinearVelocity(CarromBody_GetId(state, index));
+}
+
+void CarromBody_SetLinearVelocity(const CarromGameState* state, const int index, const b2Vec2 velocity)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld* world = state->discWorld;
+		world->vx[index] = velocity.x;
+		world->vy[index] = velocity.y;
+
+		// same as Box2D, a non zero velocity wakes the body up
+		if (b2LengthSquared(velocity) > 0.0f)
+		{
+			CarromDiscWorld_SetAwake(world, index, true);
+		}
+		return;
+	}
+
+	b2Body_SetLinearVelocity(CarromBody_GetId(state, index), velocity);
+}
+
+float CarromBody_GetAngularVelocity(const CarromGameState* state, const int index)
+{
+	if (state->discWorld != NULL)
+	{
+		return state->discWorld->angularVelocity[index];
+	}
+
+	return b2Body_GetAngularVelocity(CarromBody_GetId(state, index));
+}
+
+void CarromBody_SetAngularVelocity(const CarromGameState* state, const int index, const float angularVelocity)
+{
+	if (state->discWorld != NULL)
+	{
+		state->discWorld->angularVelocity[index] = angularVelocity;
+		if (angularVelocity != 0.0f)
+		{
+			CarromDiscWorld_SetAwake(state->discWorld, index, true);
+		}
+		return;
+	}
+
+	b2Body_SetAngularVelocity(CarromBody_GetId(state, index), angularVelocity);
+}
+
+void CarromBody_ApplyForce(const CarromGameState* state, const int index, const b2Vec2 force)
+{
+	if (state->discWorld != NULL)
+	{
+		state->discWorld->fx[index] += force.x;
+		state->discWorld->fy[index] += force.y;
+		CarromDiscWorld_SetAwake(state->discWorld, index, true);
+		return;
+	}
+
+	state->mirror->fx[index] += force.x;
+	state->mirror->fy[index] += force.y;
+	b2Body_ApplyForceToCenter(CarromBody_GetId(state, index), force, true);
+}
+
+bool CarromEngine_IsValid(const CarromGameState* state)
+{
+	if (state->discWorld != NULL)
+	{
+		return true;
+	}
+
+	return b2World_IsValid(state->worldId);
+}
+
+void CarromEngine_Step(const CarromGameState* state, const float dt, const int subStep)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld_Step(state->discWorld, dt, subStep);
+		return;
+	}
+
+	b2World_Step(state->worldId, dt, subStep);
+
+	// only moved bodies report a transform, the others kept theirs
+	CarromBodyMirror* mirror = state->mirror;
+	mirror->movedMask = 0;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		mirror->fx[i] = 0.0f;
+		mirror->fy[i] = 0.0f;
+	}
+
+	const b2BodyEvents bodyEvents = b2World_GetBodyEvents(state->worldId);
+	for (int i = 0; i < bodyEvents.moveCount; i++)
+	{
+		const b2BodyMoveEvent* moveEvent = &bodyEvents.moveEvents[i];
+		const int32_t idx = (int32_t)(intptr_t)moveEvent->userData;
+		if (idx >= 0 && idx < NUM_OF_OBJECTS)
+		{
+			mirror->px[idx] = moveEvent->transform.p.x;
+			mirror->py[idx] = moveEvent->transform.p.y;
+			mirror->movedMask |= MACARON_OBJ_BIT(idx);
+		}
+	}
+}
+
+uint32_t CarromEngine_GetMovedMask(const CarromGameState* state)
+{
+	if (state->discWorld != NULL)
+	{
+		return state->discWorld->movedMask;
+	}
+
+	return state->mirror->movedMask;
+}
+
+bool CarromEngine_HasSensorEvents(const CarromGameState* state)
+{
+	if (state->discWorld != NULL)
+	{
+		return state->discWorld->numPocketed > 0;
+	}
+
+	const b2SensorEvents sensorEvents = b2World_GetSensorEvents(state->worldId);
+	return sensorEvents.beginCount > 0 || sensorEvents.endCount > 0;
+}
+
+int CarromEngine_GetPocketed(const CarromGameState* state, int8_t* objectIndexes, int8_t* pocketIndexes)
+{
+	if (state->discWorld != NULL)
+	{
+		const CarromDiscWorld* world = state->discWorld;
+		for (int i = 0; i < world->numPocketed; i++)
+		{
+			objectIndexes[i] = world->pocketedObjects[i];
+			if (pocketIndexes != NULL)
+			{
+				pocketIndexes[i] = world->pocketedPockets[i];
+			}
+		}
+		return world->numPocketed;
+	}
+
+	int count = 0;
+
+	const b2SensorEvents sensorEvents = b2World_GetSensorEvents(state->worldId);
+	for (int i = 0; i < sensorEvents.beginCount && count < NUM_OF_OBJECTS; i++)
+	{
+		const b2SensorBeginTouchEvent* sensorEvent = &sensorEvents.beginEvents[i];
+		const b2ShapeId sensorShapeId = sensorEvent->sensorShapeId;
+		const b2BodyId sensorBodyId = b2Shape_GetBody(sensorShapeId);
+
+		if (!B2_ID_EQUALS(sensorBodyId, state->wallBodyId))
+		{
+			continue;
+		}
+
+		const b2ShapeId visitorId = sensorEvent->visitorShapeId;
+		const b2BodyId bodyId = b2Shape_GetBody(visitorId);
+
+		const int32_t objectIndex = (int32_t)(intptr_t)b2Body_GetUserData(bodyId);
+		if (!MACARON_IS_VALID_OBJ_IDX(objectIndex))
+		{
+			continue;
+		}
+
+		objectIndexes[count] = (int8_t)objectIndex;
+		if (pocketIndexes != NULL)
+		{
+			pocketIndexes[count] = -1;
+			for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+			{
+				if (B2_ID_EQUALS(sensorShapeId, state->pockets[j]))
+				{
+					pocketIndexes[count] = (int8_t)j;
+					break;
+				}
+			}
+		}
+		count++;
+	}
+
+	return count;
+}
+
+int CarromEngine_GetContacts(const CarromGameState* state, int8_t* indexesA, int8_t* indexesB, const int capacity)
+{
+	if (state->discWorld != NULL)
+	{
+		const CarromDiscWorld* world = state->discWorld;
+		const int count = world->numContacts < capacity ? world->numContacts : capacity;
+		for (int i = 0; i < count; i++)
+		{
+			indexesA[i] = world->contactA[i];
+			indexesB[i] = world->contactB[i];
+		}
+		return count;
+	}
+
+	int count = 0;
+
+	const b2ContactEvents contactEvents = b2World_GetContactEvents(state->worldId);
+	for (int i = 0; i < contactEvents.beginCount && count < capacity; i++)
+	{
+		const b2ContactBeginTouchEvent* contactEvent = &contactEvents.beginEvents[i];
+		const b2BodyId bodyIdA = b2Shape_GetBody(contactEvent->shapeIdA);
+		const b2BodyId bodyIdB = b2Shape_GetBody(contactEvent->shapeIdB);
+
+		// the wall body carries IDX_WALL as user data
+		indexesA[count] = (int8_t)(intptr_t)b2Body_GetUserData(bodyIdA);
+		indexesB[count] = (int8_t)(intptr_t)b2Body_GetUserData(bodyIdB);
+		count++;
+	}
+
+	return count;
+}
+
+void CarromEngine_CopyPending(const CarromGameState* source, const CarromGameState* target)
+{
+	MACARON_ASSERT((source->discWorld != NULL) == (target->discWorld != NULL));
+
+	if (source->discWorld != NULL)
+	{
+		*target->discWorld = *source->discWorld;
+		return;
+	}
+
+	target->mirror->movedMask = source->mirror->movedMask;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const b2Vec2 force = {source->mirror->fx[i], source->mirror->fy[i]};
+		if ((force.x != 0.0f || force.y != 0.0f) && CarromBody_IsEnabled(target, i))
+		{
+			CarromBody_ApplyForce(target, i, force);
+		}
+	}
+}
+
+void CarromEngine_Destroy(CarromGameState* state)
+{
+	if (state->discWorld != NULL)
+	{
+		CarromDiscWorld_Destroy(state->discWorld);
+		state->discWorld = NULL;
+	}
+
+	if (b2World_IsValid(state->worldId))
+	{
+		b2DestroyWorld(state->worldId);
+	}
+	state->worldId = b2_nullWorldId;
+
+	free(state->mirror);
+	state->mirror = NULL;
+}
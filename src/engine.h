@@ -0,0 +1,92 @@
+#pragma once
+
+#include <macaron/types.h>
+
+// Contiguous copy of the Box2D body state read on hot paths, written by the calls below and by CarromEngine_Step
+typedef struct CarromBodyMirror
+{
+	// positions
+	float px[NUM_OF_OBJECTS];
+	float py[NUM_OF_OBJECTS];
+	// enabled bodies
+	uint32_t enableMask;
+	// bodies that moved during the last step
+	uint32_t movedMask;
+	// forces applied during the next step, Box2D does not report them back
+	float fx[NUM_OF_OBJECTS];
+	float fy[NUM_OF_OBJECTS];
+
+} CarromBodyMirror;
+
+/**
+ * Engine agnostic access to the bodies of a game state, every call goes either to Box2D
+ * or to the disc world depending on CarromWorldDef.engine, index is an object index
+ */
+
+bool CarromBody_Exists(const CarromGameState* state, int index);
+
+bool CarromBody_IsEnabled(const CarromGameState* state, int index);
+
+void CarromBody_Enable(const CarromGameState* state, int index);
+
+void CarromBody_Disable(const CarromGameState* state, int index);
+
+bool CarromBody_IsAwake(const CarromGameState* state, int index);
+
+void CarromBody_SetAwake(const CarromGameState* state, int index, bool awake);
+
+b2Vec2 CarromBody_GetPosition(const CarromGameState* state, int index);
+
+b2Rot CarromBody_GetRotation(const CarromGameState* state, int index);
+
+void CarromBody_SetTransform(const CarromGameState* state, int index, b2Vec2 position, b2Rot rotation);
+
+b2Vec2 CarromBody_GetLinearVelocity(const CarromGameState* state, int index);
+
+void CarromBody_SetLinearVelocity(const CarromGameState* state, int index, b2Vec2 velocity);
+
+float CarromBody_GetAngularVelocity(const CarromGameState* state, int index);
+
+void CarromBody_SetAngularVelocity(const CarromGameState* state, int index, float angularVelocity);
+
+/**
+ * Apply a force to the center of the body for the next step and wake it up
+ */
+void CarromBody_ApplyForce(const CarromGameState* state, int index, b2Vec2 force);
+
+/**
+ * true if the world of the game state exists
+ */
+bool CarromEngine_IsValid(const CarromGameState* state);
+
+void CarromEngine_Step(const CarromGameState* state, float dt, int subStep);
+
+/**
+ * Bodies that moved during the last step, one MACARON_OBJ_BIT per object
+ */
+uint32_t CarromEngine_GetMovedMask(const CarromGameState* state);
+
+/**
+ * true if a pocket sensor began or ended an overlap during the last step
+ */
+bool CarromEngine_HasSensorEvents(const CarromGameState* state);
+
+/**
+ * Objects which entered a pocket during the last step, see CarromGameState_CollectPocketed
+ */
+int CarromEngine_GetPocketed(const CarromGameState* state, int8_t* objectIndexes, int8_t* pocketIndexes);
+
+/**
+ * Pairs of objects which began touching during the last step, IDX_WALL stands for the cushion
+ *
+ * @return number of pairs, at most capacity
+ */
+int CarromEngine_GetContacts(const CarromGameState* state, int8_t* indexesA, int8_t* indexesB, int capacity);
+
+/**
+ * Copy what a full snapshot does not carry, pending forces and the step bookkeeping,
+ * a disc world is copied whole, Box2D contact caches and sleep timers stay behind
+ */
+void CarromEngine_CopyPending(const CarromGameState* source, const CarromGameState* target);
+
+void CarromEngine_Destroy(CarromGameState* state);
@@ -0,0 +1,85 @@
+#include "core.h"
+
+#include <macaron/macaron.h>
+
+void CarromFrame_ToSoA(const CarromFrame* frame, CarromFrameSoA* soa)
+{
+	MACARON_ASSERT(frame != NULL);
+	MACARON_ASSERT(soa != NULL);
+	if (frame == NULL || soa == NULL)
+	{
+		return;
+	}
+
+	soa->index = frame->index;
+	soa->strikerHitPocket = frame->strikerHitPocket;
+	soa->pucksHitPocket = frame->pucksHitPocket;
+	soa->time = frame->time;
+	soa->validMask = 0;
+	soa->enableMask = 0;
+	soa->restMask = 0;
+	soa->hitPocketMask = 0;
+	soa->numHits = 0;
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const CarromObjectSnapshot* snapshot = &frame->snapshots[i];
+		soa->x[i] = snapshot->position.x;
+		soa->y[i] = snapshot->position.y;
+
+		if (snapshot->index != i)
+		{
+			continue;
+		}
+
+		const uint32_t bit = MACARON_OBJ_BIT(i);
+		soa->validMask |= bit;
+		soa->enableMask |= snapshot->enable ? bit : 0;
+		soa->restMask |= snapshot->rest ? bit : 0;
+		soa->hitPocketMask |= snapshot->hitPocket ? bit : 0;
+
+		if (snapshot->hitEvent != CarromHitEventType_None || snapshot->hitPocket)
+		{
+			CarromHitRecord* hit = &soa->hits[soa->numHits++];
+			hit->index = (int8_t)i;
+			hit->hitEvent = (int8_t)snapshot->hitEvent;
+			hit->hitPocketIndex = snapshot->hitPocketIndex;
+		}
+	}
+}
+
+void CarromFrameSoA_ToFrame(const CarromFrameSoA* soa, CarromFrame* frame)
+{
+	MACARON_ASSERT(soa != NULL);
+	MACARON_ASSERT(frame != NULL);
+	if (soa == NULL || frame == NULL)
+	{
+		return;
+	}
+
+	*frame = (CarromFrame){0};
+	frame->index = soa->index;
+	frame->strikerHitPocket = soa->strikerHitPocket;
+	frame->pucksHitPocket = soa->pucksHitPocket;
+	frame->time = soa->time;
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		CarromObjectSnapshot* snapshot = &frame->snapshots[i];
+		const uint32_t bit = MACARON_OBJ_BIT(i);
+
+		snapshot->index = (soa->validMask & bit) != 0 ? (int8_t)i : -1;
+		snapshot->position = (b2Vec2){soa->x[i], soa->y[i]};
+		snapshot->enable = (soa->enableMask & bit) != 0;
+		snapshot->rest = (soa->restMask & bit) != 0;
+		snapshot->hitPocket = (soa->hitPocketMask & bit) != 0;
+	}
+
+	for (int i = 0; i < soa->numHits; i++)
+	{
+		const CarromHitRecord* hit = &soa->hits[i];
+		CarromObjectSnapshot* snapshot = &frame->snapshots[hit->index];
+		snapshot->hitEvent = (CarromHitEventType)hit->hitEvent;
+		snapshot->hitPocketIndex = hit->hitPocketIndex;
+	}
+}
@@ -2,6 +2,13 @@
 #include <macaron/macaron.h>
 
 #include "core.h"
+#include "disc_world.h"
+#include "engine.h"
+#include "geometry.h"
+#include "overlap.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 const int32_t sPuckIndexes[PUCK_IDX_COUNT] = {
 	IDX_PUCK_BLACK_START,
@@ -81,11 +88,7 @@ void CarromGameState_CreateImpl(CarromGameState* state,
 		return;
 	}
 
-	if (b2World_IsValid(state->worldId))
-	{
-		b2DestroyWorld(state->worldId);
-		state->worldId = b2_nullWorldId;
-	}
+	CarromEngine_Destroy(state);
 
 	state->worldDef = *def;
 	state->pocketDef = *pocketDef;
@@ -93,6 +96,30 @@ void CarromGameState_CreateImpl(CarromGameState* state,
 	state->strikerPhysicsDef = *strikerPhysicsDef;
 	state->strikerLimitDef = *strikerLimitDef;
 
+	// disc engines, no Box2D objects at all
+	if (def->engine == CarromEngine_Disc || def->engine == CarromEngine_Event)
+	{
+		state->wallBodyId = b2_nullBodyId;
+		for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+		{
+			state->pockets[i] = b2_nullShapeId;
+		}
+		for (int i = 0; i < NUM_OF_OBJECTS; i++)
+		{
+			state->objects[i].index = MACARON_IS_VALID_OBJ_IDX(i) ? i : -1;
+			state->objects[i].bodyId = b2_nullBodyId;
+		}
+
+		state->discWorld = CarromDiscWorld_Create(def, pocketDef, puckPhysicsDef, strikerPhysicsDef);
+		if (state->discWorld != NULL)
+		{
+			return;
+		}
+
+		// out of memory for the disc world, Box2D keeps the state usable unless its mirror fails too
+		state->worldDef.engine = CarromEngine_Box2D;
+	}
+
 	// world
 	{
 		b2WorldDef worldDef = b2DefaultWorldDef();
@@ -102,6 +129,26 @@ void CarromGameState_CreateImpl(CarromGameState* state,
 		worldDef.gravity = b2Vec2_zero;
 
 		state->worldId = b2CreateWorld(&worldDef);
+
+		// every body starts disabled at the origin
+		state->mirror = calloc(1, sizeof(CarromBodyMirror));
+		if (state->mirror == NULL)
+		{
+			// out of memory, a null world makes CarromEngine_IsValid reject the state
+			b2DestroyWorld(state->worldId);
+			state->worldId = b2_nullWorldId;
+			state->wallBodyId = b2_nullBodyId;
+			for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+			{
+				state->pockets[i] = b2_nullShapeId;
+			}
+			for (int i = 0; i < NUM_OF_OBJECTS; i++)
+			{
+				state->objects[i].index = -1;
+				state->objects[i].bodyId = b2_nullBodyId;
+			}
+			return;
+		}
 	}
 
 	// table walls
@@ -155,17 +202,8 @@ void CarromGameState_CreateImpl(CarromGameState* state,
 
 	// pockets
 	{
-		const float left = -def->width / 2 + pocketDef->cornerOffsetX;
-		const float right = def->width / 2 - pocketDef->cornerOffsetX;
-		const float top = def->height / 2 - pocketDef->cornerOffsetY;
-		const float bottom = -def->height / 2 + pocketDef->cornerOffsetY;
-
-		const b2Vec2 pocketsPositions[MAX_POCKET_CAPACITY] = {
-			{left, top},
-			{right, top},
-			{right, bottom},
-			{left, bottom},
-		};
+		b2Vec2 pocketsPositions[MAX_POCKET_CAPACITY];
+		CarromPocketPositions(def, pocketDef, pocketsPositions);
 
 		for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
 		{
@@ -248,525 +286,750 @@ MACARON_API void CarromGameState_SetPuckPosition(const CarromGameState* state, c
 			continue;
 		}
 
-		const CarromObject* puck = &state->objects[posDef.index];
-		b2Body_SetTransform(puck->bodyId, posDef.position, b2Rot_identity);
-		b2Body_Enable(puck->bodyId);
+		CarromBody_SetTransform(state, posDef.index, posDef.position, b2Rot_identity);
+		CarromBody_Enable(state, posDef.index);
 	}
 }
 
-bool CarromGameState_HasMovement(const CarromGameState* state)
+/**
+ * Relaxation of the pucks of a table, pockets must outlive the def
+ */
+static CarromRelaxDef CarromMakeRelaxDef(const CarromWorldDef* worldDef, const CarromObjectPhysicsDef* puckPhysicsDef,
+                                         const CarromPocketDef* pocketDef, const float clearance, const int maxIterations,
+                                         const float tolerance, b2Vec2 pockets[MAX_POCKET_CAPACITY])
 {
-	MACARON_ASSERT(state != NULL);
-	if (state == NULL)
-	{
-		return false;
-	}
-
-	MACARON_ASSERT(b2World_IsValid(state->worldId));
-
-	const b2BodyEvents bodyEvents = b2World_GetBodyEvents(state->worldId);
-	if (bodyEvents.moveCount > 0)
-	{
-		return true;
-	}
-
-	return false;
+	const float r = puckPhysicsDef->radius;
+	CarromPocketPositions(worldDef, pocketDef, pockets);
+
+	CarromRelaxDef def = {0};
+	def.distance = 2 * r + clearance;
+	def.limitX = worldDef->width / 2 - r - clearance;
+	def.limitY = worldDef->height / 2 - r - clearance;
+	def.pockets = pockets;
+	def.numPockets = MAX_POCKET_CAPACITY;
+	// a puck touching the pocket sensor is already pocketed
+	def.pocketDistance = pocketDef->radius + r + clearance;
+	def.maxIterations = maxIterations;
+	def.tolerance = tolerance;
+	return def;
 }
 
-bool CarromGameState_HasSensorEvents(const CarromGameState* state)
+bool CarromGameState_PlaceLayout(const CarromGameState* state, const CarromObjectPositionDef* positions, const int count,
+                                 const CarromLayoutDef* layoutDef)
 {
 	MACARON_ASSERT(state != NULL);
-	if (state == NULL)
+	MACARON_ASSERT(positions != NULL || count == 0);
+	MACARON_ASSERT(layoutDef != NULL);
+	if (state == NULL || (positions == NULL && count > 0) || layoutDef == NULL)
 	{
 		return false;
 	}
 
-	MACARON_ASSERT(b2World_IsValid(state->worldId));
-
-	const b2SensorEvents sensorEvents = b2World_GetSensorEvents(state->worldId);
-	if (sensorEvents.beginCount > 0 || sensorEvents.endCount > 0)
+	// slot of every object index, later entries of the same puck win
+	int slots[NUM_OF_OBJECTS];
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		return true;
+		slots[i] = -1;
 	}
 
-	return false;
-}
-
-void CarromGameState_Step(const CarromGameState* state)
-{
-	// MACARON_ASSERT(state != NULL);
-	b2World_Step(state->worldId, state->worldDef.frameDuration, state->worldDef.subStep);
-}
-
-typedef struct
-{
-	bool found;
-	float minDistance;
-	b2Vec2 nearestPos;
-} FindNearestPuckData;
+	float px[PUCK_IDX_COUNT];
+	float py[PUCK_IDX_COUNT];
+	int8_t indexes[PUCK_IDX_COUNT];
+	int numMoving = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const int idx = positions[i].index;
+		if (!MACARON_IS_VALID_PUCK_IDX(idx))
+		{
+			continue;
+		}
 
-FindNearestPuckData CarromGameState_FindNearestPuck(const CarromGameState* state, const CarromObject* target,
-                                                    const b2Vec2 pos)
-{
-	float minDistance = state->worldDef.width + state->worldDef.height;
-	FindNearestPuckData result = {false, minDistance, b2Vec2_zero};
+		if (slots[idx] < 0)
+		{
+			slots[idx] = numMoving;
+			indexes[numMoving] = (int8_t)idx;
+			numMoving++;
+		}
+		px[slots[idx]] = positions[i].position.x;
+		py[slots[idx]] = positions[i].position.y;
+	}
 
+	// pucks missing from the layout are either removed or kept as fixed obstacles
+	int total = numMoving;
 	for (int i = 0; i < PUCK_IDX_COUNT; i++)
 	{
 		const int idx = sPuckIndexes[i];
-		const CarromObject* puck = &state->objects[idx];
-		if (puck == target || !b2Body_IsEnabled(puck->bodyId))
+		if (slots[idx] >= 0)
 		{
 			continue;
 		}
 
-		const b2Vec2 puckPos = b2Body_GetPosition(puck->bodyId);
-		const float distance = b2Distance(puckPos, pos);
-		if (distance < minDistance)
+		if (layoutDef->disableOthers)
+		{
+			CarromBody_Disable(state, idx);
+		}
+		else if (CarromBody_IsEnabled(state, idx))
 		{
-			minDistance = distance;
-			result.found = true;
-			result.nearestPos = puckPos;
-			result.minDistance = distance;
+			const b2Vec2 pos = CarromBody_GetPosition(state, idx);
+			px[total] = pos.x;
+			py[total] = pos.y;
+			total++;
 		}
 	}
 
-	return result;
-}
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	const CarromRelaxDef relaxDef = CarromMakeRelaxDef(&state->worldDef, &state->puckPhysicsDef, &state->pocketDef,
+	                                                   layoutDef->clearance, layoutDef->maxIterations, layoutDef->tolerance,
+	                                                   pockets);
+	const float violation = CarromRelaxDiscs(px, py, numMoving, total, &relaxDef);
 
-b2Vec2 CarromGameState_GetPuckPosition(const CarromGameState* state, const int index)
-{
-	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
-	if (state == NULL)
+	for (int i = 0; i < numMoving; i++)
 	{
-		return b2Vec2_zero;
+		CarromBody_SetTransform(state, indexes[i], (b2Vec2){px[i], py[i]}, b2Rot_identity);
+		CarromBody_Enable(state, indexes[i]);
 	}
 
-	const CarromObject* puck = &state->objects[index];
-	return b2Body_GetPosition(puck->bodyId);
+	return violation <= layoutDef->tolerance;
 }
 
-b2Vec2 CarromGameState_GetStrikerPosition(const CarromGameState* state)
+bool CarromGameState_Settle(const CarromGameState* state, const float tolerance, const int maxIters)
 {
 	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(tolerance >= 0.0f);
 	if (state == NULL)
 	{
-		return b2Vec2_zero;
+		return false;
 	}
 
-	return b2Body_GetPosition(state->objects[IDX_STRIKER].bodyId);
-}
-
-b2Vec2 CarromGameState_PlacePuck(const CarromGameState* state, const CarromObject* puck, const float step)
-{
-	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(puck != NULL);
-	if (state == NULL || puck == NULL)
+	float px[PUCK_IDX_COUNT];
+	float py[PUCK_IDX_COUNT];
+	b2Vec2 original[PUCK_IDX_COUNT];
+	int8_t indexes[PUCK_IDX_COUNT];
+	int count = 0;
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
 	{
-		return b2Vec2_zero;
+		const int idx = sPuckIndexes[i];
+		if (!CarromBody_IsEnabled(state, idx))
+		{
+			continue;
+		}
+
+		original[count] = CarromBody_GetPosition(state, idx);
+		px[count] = original[count].x;
+		py[count] = original[count].y;
+		indexes[count] = (int8_t)idx;
+		count++;
 	}
 
-	const b2Vec2 targetPos = b2Body_GetPosition(puck->bodyId);
-	const FindNearestPuckData nearestData = CarromGameState_FindNearestPuck(state, puck, targetPos);
+	// settling only separates the pucks, one over a pocket still falls in
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	CarromRelaxDef relaxDef = CarromMakeRelaxDef(&state->worldDef, &state->puckPhysicsDef, &state->pocketDef, tolerance,
+	                                             maxIters, tolerance, pockets);
+	relaxDef.numPockets = 0;
+	const float violation = CarromRelaxDiscs(px, py, count, count, &relaxDef);
 
-	if (!nearestData.found)
+	// untouched pucks keep their contacts
+	for (int i = 0; i < count; i++)
 	{
-		// printf("CarromGameState_PlacePuck cannot find nearest puck\n");
-		return targetPos;
+		if (px[i] != original[i].x || py[i] != original[i].y)
+		{
+			CarromBody_SetTransform(state, indexes[i], (b2Vec2){px[i], py[i]}, b2Rot_identity);
+		}
 	}
 
-	const float r = state->puckPhysicsDef.radius;
-	if (nearestData.minDistance > r * 2)
+	for (int idx = 0; idx < NUM_OF_OBJECTS; idx++)
 	{
-		// printf("CarromGameState_PlacePuck no overlaps\n");
-		return targetPos;
+		if (MACARON_IS_VALID_OBJ_IDX(idx) && CarromBody_IsEnabled(state, idx))
+		{
+			CarromBody_SetLinearVelocity(state, idx, b2Vec2_zero);
+			CarromBody_SetAngularVelocity(state, idx, 0.0f);
+		}
 	}
 
-	const b2Circle circleSrc = {{0.0f, 0.0f}, r};
-	const b2Circle circleDst = {{0.0f, 0.0f}, r};
-
-	const b2Transform transformSrc = {targetPos, b2Rot_identity};
-	const b2Transform transformDst = {nearestData.nearestPos, b2Rot_identity};
+	return violation <= tolerance;
+}
 
-	const b2Manifold m = b2CollideCircles(&circleSrc, transformSrc, &circleDst, transformDst);
-	if (m.pointCount > 0)
+int CarromSettledPuckPosition(CarromSettledLayoutCache* cache, const CarromGameDef* def, const int numOfPucks,
+                              CarromObjectPositionDef* positions)
+{
+	MACARON_ASSERT(def != NULL);
+	if (def == NULL || positions == NULL || numOfPucks < PUCK_IDX_COUNT)
 	{
-		const float pushOut = (r * 2) - nearestData.minDistance + 0.001f;
-		b2Vec2 sepVec = b2MulSV(pushOut, b2Normalize(m.normal));
+		return PUCK_IDX_COUNT;
+	}
+
+	const float key[7] = {
+		def->worldDef.width,   def->worldDef.height,        def->puckPhysicsDef.radius,  def->puckPhysicsDef.gap,
+		def->pocketDef.radius, def->pocketDef.cornerOffsetX, def->pocketDef.cornerOffsetY,
+	};
 
-		if (pushOut < 0.00001f || b2Length(sepVec) < 0.00001f)
+	for (int i = 0; cache != NULL && i < cache->count; i++)
+	{
+		if (memcmp(cache->entries[i].key, key, sizeof(key)) == 0)
 		{
-			sepVec.x = 1.0f;
-			sepVec.y = 0.0f;
+			memcpy(positions, cache->entries[i].positions, sizeof(cache->entries[i].positions));
+			return PUCK_IDX_COUNT;
 		}
+	}
 
-		b2Body_SetTransform(puck->bodyId, b2Add(targetPos, sepVec), b2Rot_identity);
+	CarromDefaultPuckPosition(def->puckPhysicsDef.radius, def->puckPhysicsDef.gap, PUCK_IDX_COUNT, positions);
 
-		const b2Vec2 stepVec = b2MulSV(step, b2Normalize(sepVec));
+	float px[PUCK_IDX_COUNT];
+	float py[PUCK_IDX_COUNT];
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
+	{
+		px[i] = positions[i].position.x;
+		py[i] = positions[i].position.y;
+	}
 
-		while (true)
-		{
-			const b2Vec2 placePos = b2Body_GetPosition(puck->bodyId);
-			const FindNearestPuckData data = CarromGameState_FindNearestPuck(state, puck, placePos);
-			if (!data.found || data.minDistance > r * 2)
-			{
-				return placePos;
-			}
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	CarromRelaxDef relaxDef = CarromMakeRelaxDef(&def->worldDef, &def->puckPhysicsDef, &def->pocketDef, 0.0001f, 64,
+	                                             0.0001f, pockets);
+	relaxDef.numPockets = 0;
+	CarromRelaxDiscs(px, py, PUCK_IDX_COUNT, PUCK_IDX_COUNT, &relaxDef);
 
-			const b2Vec2 newPos = b2Add(placePos, stepVec);
-			b2Body_SetTransform(puck->bodyId, newPos, b2Rot_identity);
-		}
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
+	{
+		positions[i].position = (b2Vec2){px[i], py[i]};
+	}
+
+	if (cache == NULL)
+	{
+		return PUCK_IDX_COUNT;
+	}
+
+	// a full cache replaces its oldest entry
+	CarromSettledLayout* entry = &cache->entries[cache->next];
+	memcpy(entry->key, key, sizeof(key));
+	memcpy(entry->positions, positions, sizeof(entry->positions));
+	cache->next = (cache->next + 1) % SETTLED_LAYOUT_CACHE_CAPACITY;
+	if (cache->count < SETTLED_LAYOUT_CACHE_CAPACITY)
+	{
+		cache->count++;
 	}
 
-	return targetPos;
+	return PUCK_IDX_COUNT;
 }
 
-b2Vec2 CarromGameState_PlacePuckToPos(const CarromGameState* state, const int index, const b2Vec2 pos)
+bool CarromGameState_HasMovement(const CarromGameState* state)
 {
 	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
 	if (state == NULL)
 	{
-		return b2Vec2_zero;
+		return false;
 	}
 
-	const CarromObject* puck = &state->objects[index];
-	b2Body_SetTransform(puck->bodyId, pos, b2Rot_identity);
+	MACARON_ASSERT(CarromEngine_IsValid(state));
 
-	const float step = state->puckPhysicsDef.radius / 200.0f;
-	return CarromGameState_PlacePuck(state, puck, step);
+	return CarromEngine_GetMovedMask(state) != 0;
 }
 
-void CarromGameState_PlacePuckToPosUnsafe(const CarromGameState* state, const int index, const b2Vec2 pos, bool enable)
+static float CarromGameState_ObjectRadius(const CarromGameState* state, const int index)
 {
-	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
-
-	const CarromObject* puck = &state->objects[index];
-	b2Body_SetTransform(puck->bodyId, pos, b2Rot_identity);
-	if (enable)
-	{
-		b2Body_Enable(puck->bodyId);
-	}
-	else
-	{
-		b2Body_Disable(puck->bodyId);
-	}
+	return index == IDX_STRIKER ? state->strikerPhysicsDef.radius : state->puckPhysicsDef.radius;
 }
 
-b2Vec2 CarromGameState_PlacePuckToCenter(const CarromGameState* state, const int index)
+static float CarromGameState_ObjectDamping(const CarromGameState* state, const int index)
 {
-	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
-
-	const CarromObject* puck = &state->objects[index];
+	return index == IDX_STRIKER ? state->strikerPhysicsDef.bodyLinearDamping : state->puckPhysicsDef.bodyLinearDamping;
+}
 
-	b2Body_SetTransform(puck->bodyId, b2Vec2_zero, b2Rot_identity);
+// Per evaluation stepping state
+typedef struct CarromStepClock
+{
+	// time since the evaluation started
+	float time;
+	// time each object stayed slower than its rest speed
+	float restTimes[NUM_OF_OBJECTS];
+} CarromStepClock;
 
-	if (!b2Body_IsEnabled(puck->bodyId))
+/**
+ * Advance the rest timers by one frame, an object rests once it stayed slower than its rest speed for the hold time
+ *
+ * objects without a rest speed only rest when Box2D puts them to sleep, when no object has one the Box2D move events
+ * decide alone, velocities are cleared once everything rests so that the next strike starts from a still table
+ *
+ * @param state Game state
+ * @param clock stepping state, zeroed by the caller before the first step
+ * @param dt duration of the last frame
+ *
+ * @return true if there are still movements
+ */
+bool CarromGameState_UpdateRest(const CarromGameState* state, CarromStepClock* clock, const float dt)
+{
+	if (state->puckPhysicsDef.restSpeed <= 0.0f && state->strikerPhysicsDef.restSpeed <= 0.0f)
 	{
-		return b2Vec2_zero;
+		return CarromGameState_HasMovement(state);
 	}
 
-	return CarromGameState_PlacePuck(state, puck, 0.001f);
-}
-
-FindNearestPuckData CarromGameState_FindStrikerNearestPuck(const CarromGameState* state, const b2Vec2 pos)
-{
-	float minDistance = state->worldDef.width + state->worldDef.height;
-
-	FindNearestPuckData result = {false, minDistance, b2Vec2_zero};
+	const float holdTime = state->worldDef.restHoldTime;
+	float* restTimes = clock->restTimes;
 
-	for (int i = 0; i < PUCK_IDX_COUNT; i++)
+	bool moving = false;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		const int idx = sPuckIndexes[i];
-		const CarromObject* puck = &state->objects[idx];
-
-		if (!b2Body_IsEnabled(puck->bodyId))
+		if (!CarromBody_Exists(state, i) || !CarromBody_IsEnabled(state, i) || !CarromBody_IsAwake(state, i))
 		{
+			restTimes[i] = holdTime;
 			continue;
 		}
 
-		const b2Vec2 puckPos = b2Body_GetPosition(puck->bodyId);
-		const float distance = b2Distance(puckPos, pos);
-		if (distance < minDistance)
+		const float restSpeed = i == IDX_STRIKER ? state->strikerPhysicsDef.restSpeed : state->puckPhysicsDef.restSpeed;
+		const b2Vec2 velocity = CarromBody_GetLinearVelocity(state, i);
+		if (restSpeed > 0.0f && b2LengthSquared(velocity) < restSpeed * restSpeed)
+		{
+			restTimes[i] += dt;
+		}
+		else
+		{
+			restTimes[i] = 0.0f;
+		}
+
+		if (restSpeed <= 0.0f || restTimes[i] < holdTime)
 		{
-			minDistance = distance;
-			result.found = true;
-			result.nearestPos = puckPos;
-			result.minDistance = distance;
+			moving = true;
 		}
 	}
 
-	return result;
+	if (moving)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (CarromBody_Exists(state, i) && CarromBody_IsEnabled(state, i))
+		{
+			CarromBody_SetLinearVelocity(state, i, b2Vec2_zero);
+			CarromBody_SetAngularVelocity(state, i, 0.0f);
+		}
+	}
+
+	return false;
 }
 
-b2Vec2 CarromGameState_LimitStrikerPos(const CarromGameState* state, const CarromTablePosition tablePos, const b2Vec2 pos)
+/**
+ * Pick the duration and sub step count of the next frame
+ *
+ * frames stretch up to maxFrameDuration while no body can reach a cushion, a pocket or another body,
+ * sub steps follow the distance travelled in the frame, frameDuration and subStep are kept as soon as
+ * a contact is possible within the frame
+ *
+ * the event engine is exact whatever the duration, its adaptive frames end at the next event instead,
+ * and frames nobody samples jump straight to it
+ *
+ * @param state Game state
+ * @param jump no frame is sampled, the event engine may skip to the next event
+ * @param subStep Output sub step count
+ *
+ * @return frame duration
+ */
+static float CarromGameState_ChooseStep(const CarromGameState* state, const bool jump, int* subStep)
 {
-	b2Vec2 finalPos = pos;
+	const CarromWorldDef* worldDef = &state->worldDef;
+	*subStep = worldDef->subStep;
 
-	const float strikerLimitWidth = state->strikerLimitDef.width;
-	const float centerOffset = state->strikerLimitDef.centerOffset;
-
-	if (strikerLimitWidth == 0.0f || centerOffset == 0.0f)
+	if (state->discWorld != NULL && state->discWorld->eventDriven && (jump || worldDef->adaptiveStep))
 	{
-		return finalPos;
-	}
+		const float maxFrameDuration = jump ? FLT_MAX : b2MaxFloat(worldDef->maxFrameDuration, worldDef->frameDuration);
+		const float eventTime = CarromDiscWorld_NextEventTime(state->discWorld, maxFrameDuration);
 
-	const float horizontalLeftX = -strikerLimitWidth / 2;
-	const float horizontalRightX = strikerLimitWidth / 2;
-	const float horizontalTopY = centerOffset;
-	const float horizontalBottomY = -centerOffset;
-	const float verticalTopY = strikerLimitWidth / 2;
-	const float verticalBottomY = -strikerLimitWidth / 2;
-	const float verticalLeftX = -centerOffset;
-	const float verticalRightX = centerOffset;
+		// nothing happens at all, keep the regular pace for rest detection
+		if (eventTime == FLT_MAX)
+		{
+			return worldDef->frameDuration;
+		}
 
-	if (tablePos == CarromTablePosition_Bottom)
-	{
-		finalPos.y = horizontalBottomY;
-	}
-	else if (tablePos == CarromTablePosition_Left)
-	{
-		finalPos.x = verticalLeftX;
-	}
-	else if (tablePos == CarromTablePosition_Top)
-	{
-		finalPos.y = horizontalTopY;
+		return b2MaxFloat(eventTime, worldDef->frameDuration);
 	}
-	else if (tablePos == CarromTablePosition_Right)
+	if (!worldDef->adaptiveStep)
 	{
-		finalPos.x = verticalRightX;
+		return worldDef->frameDuration;
 	}
 
-	if (tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top)
+	b2Vec2 positions[NUM_OF_OBJECTS];
+	float speeds[NUM_OF_OBJECTS];
+	bool enables[NUM_OF_OBJECTS];
+
+	float maxSpeed = 0.0f;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		// limit x
-		if (finalPos.x < horizontalLeftX)
+		enables[i] = CarromBody_Exists(state, i) && CarromBody_IsEnabled(state, i);
+		speeds[i] = 0.0f;
+		if (!enables[i])
 		{
-			finalPos.x = horizontalLeftX;
+			continue;
 		}
-		if (finalPos.x > horizontalRightX)
+
+		positions[i] = CarromBody_GetPosition(state, i);
+		if (CarromBody_IsAwake(state, i))
 		{
-			finalPos.x = horizontalRightX;
+			speeds[i] = b2Length(CarromBody_GetLinearVelocity(state, i));
+			maxSpeed = b2MaxFloat(maxSpeed, speeds[i]);
 		}
 	}
-	else if (tablePos == CarromTablePosition_Left || tablePos == CarromTablePosition_Right)
+
+	if (maxSpeed == 0.0f)
+	{
+		return worldDef->frameDuration;
+	}
+
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	CarromPocketPositions(worldDef, &state->pocketDef, pockets);
+
+	// earliest time anything may touch, damping only slows bodies down
+	float contactTime = FLT_MAX;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		// limit y
-		if (finalPos.y < verticalBottomY)
+		if (speeds[i] == 0.0f)
+		{
+			continue;
+		}
+
+		const float radius = CarromGameState_ObjectRadius(state, i);
+		const b2Vec2 p = positions[i];
+
+		const float wallGap = b2MinFloat(worldDef->width / 2 - radius - b2AbsFloat(p.x),
+		                                 worldDef->height / 2 - radius - b2AbsFloat(p.y));
+		contactTime = b2MinFloat(contactTime, b2MaxFloat(wallGap, 0.0f) / speeds[i]);
+
+		for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
 		{
-			finalPos.y = verticalBottomY;
+			const float gap = b2Distance(p, pockets[j]) - state->pocketDef.radius - radius;
+			contactTime = b2MinFloat(contactTime, b2MaxFloat(gap, 0.0f) / speeds[i]);
 		}
-		if (finalPos.y > verticalTopY)
+
+		for (int j = 0; j < NUM_OF_OBJECTS; j++)
 		{
-			finalPos.y = verticalTopY;
+			if (j == i || !enables[j])
+			{
+				continue;
+			}
+
+			const float gap = b2Distance(p, positions[j]) - radius - CarromGameState_ObjectRadius(state, j);
+			contactTime = b2MinFloat(contactTime, b2MaxFloat(gap, 0.0f) / (speeds[i] + speeds[j]));
 		}
 	}
 
-	return finalPos;
-}
+	const float maxFrameDuration = b2MaxFloat(worldDef->maxFrameDuration, worldDef->frameDuration);
+	const float dt = b2ClampFloat(contactTime, worldDef->frameDuration, maxFrameDuration);
 
-void CarromGameState_EnableStriker(const CarromGameState* state)
-{
-	MACARON_ASSERT(state != NULL);
-	if (state == NULL)
+	// bound the distance travelled per sub step
+	const float maxTravel = worldDef->maxSubStepTravel * state->puckPhysicsDef.radius;
+	int travelSubStep = maxTravel > 0.0f ? (int)ceilf(maxSpeed * dt / maxTravel) : worldDef->subStep;
+	if (contactTime < dt && travelSubStep < worldDef->subStep)
 	{
-		return;
+		travelSubStep = worldDef->subStep;
 	}
-	b2Body_Enable(state->objects[IDX_STRIKER].bodyId);
+
+	const int maxSubStep = worldDef->maxSubStep > worldDef->subStep ? worldDef->maxSubStep : worldDef->subStep;
+	*subStep = travelSubStep < 1 ? 1 : travelSubStep > maxSubStep ? maxSubStep : travelSubStep;
+
+	return dt;
 }
 
-void CarromGameState_DisableStriker(const CarromGameState* state)
+/**
+ * Step the world by one frame, fixed or adaptive depending on the world def
+ *
+ * @param state Game state
+ * @param jump no frame is sampled, see CarromGameState_ChooseStep
+ *
+ * @return frame duration
+ */
+float CarromGameState_StepFrame(const CarromGameState* state, const bool jump)
 {
-	MACARON_ASSERT(state != NULL);
-	if (state == NULL)
-	{
-		return;
-	}
-	b2Body_Disable(state->objects[IDX_STRIKER].bodyId);
+	int subStep;
+	const float dt = CarromGameState_ChooseStep(state, jump, &subStep);
+	CarromEngine_Step(state, dt, subStep);
+
+	return dt;
 }
 
-bool CarromGameState_IsStrikerEnabled(const CarromGameState* state)
+bool CarromGameState_HasSensorEvents(const CarromGameState* state)
 {
 	MACARON_ASSERT(state != NULL);
 	if (state == NULL)
 	{
 		return false;
 	}
-	return b2Body_IsEnabled(state->objects[IDX_STRIKER].bodyId);
+
+	MACARON_ASSERT(CarromEngine_IsValid(state));
+
+	return CarromEngine_HasSensorEvents(state);
 }
 
-b2Vec2 CarromGameState_PlaceStriker(const CarromGameState* state, const CarromTablePosition tablePos, const b2Vec2 pos)
+void CarromGameState_Step(const CarromGameState* state)
 {
-	const b2Vec2 finalPos = CarromGameState_LimitStrikerPos(state, tablePos, pos);
+	// MACARON_ASSERT(state != NULL);
+	CarromEngine_Step(state, state->worldDef.frameDuration, state->worldDef.subStep);
+}
 
-	const b2BodyId strikerBodyId = state->objects[IDX_STRIKER].bodyId;
-	b2Body_SetTransform(strikerBodyId, finalPos, b2Rot_identity);
+typedef struct
+{
+	bool found;
+	float minDistance;
+	b2Vec2 nearestPos;
+} FindNearestPuckData;
 
-	const FindNearestPuckData nearestData = CarromGameState_FindStrikerNearestPuck(state, finalPos);
-	if (!nearestData.found)
+/**
+ * Gather the enabled pucks for the overlap kernels, pucks do not move while placing so the set is built once per placement
+ *
+ * @param state Game state
+ * @param excludeIndex puck left out of the set, -1 to keep all of them
+ * @param set Output puck set
+ */
+static void CarromGameState_BuildPuckSet(const CarromGameState* state, const int excludeIndex, CarromPuckSet* set)
+{
+	CarromPuckSet_Clear(set);
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
 	{
-		return finalPos;
-	}
+		const int idx = sPuckIndexes[i];
+		if (idx != excludeIndex && CarromBody_IsEnabled(state, idx))
+		{
+			CarromPuckSet_Add(set, idx, CarromBody_GetPosition(state, idx));
+		}
+	}
+}
 
-	const float puckR = state->puckPhysicsDef.radius;
-	const float strikerR = state->strikerPhysicsDef.radius;
+static FindNearestPuckData CarromGameState_FindNearestInSet(const CarromGameState* state, const CarromPuckSet* set,
+                                                            const b2Vec2 pos)
+{
+	const float maxDistance = state->worldDef.width + state->worldDef.height;
+	FindNearestPuckData result = {false, maxDistance, b2Vec2_zero};
 
-	if (nearestData.minDistance > puckR + strikerR)
+	float distanceSquared;
+	const int slot = CarromPuckSet_Nearest(set, pos, &distanceSquared);
+	if (slot < 0 || distanceSquared >= maxDistance * maxDistance)
 	{
-		return finalPos;
+		return result;
 	}
 
-	// got overlap
-	const b2Circle circleStriker = {{0.0f, 0.0f}, strikerR};
-	const b2Circle circlePuck = {{0.0f, 0.0f}, puckR};
+	// one square root for the winner only
+	result.found = true;
+	result.minDistance = sqrtf(distanceSquared);
+	result.nearestPos = (b2Vec2){set->px[slot], set->py[slot]};
 
-	const b2Transform transformStriker = {finalPos, b2Rot_identity};
-	const b2Transform transformPuck = {nearestData.nearestPos, b2Rot_identity};
+	return result;
+}
+
+FindNearestPuckData CarromGameState_FindNearestPuck(const CarromGameState* state, const CarromObject* target,
+                                                    const b2Vec2 pos)
+{
+	CarromPuckSet set;
+	CarromGameState_BuildPuckSet(state, target != NULL ? target->index : -1, &set);
+
+	return CarromGameState_FindNearestInSet(state, &set, pos);
+}
 
-	const b2Manifold m = b2CollideCircles(&circleStriker, transformStriker, &circlePuck, transformPuck);
-	if (m.pointCount > 0)
+b2Vec2 CarromGameState_GetPuckPosition(const CarromGameState* state, const int index)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
+	if (state == NULL)
 	{
-		const float pushOut = (strikerR + puckR) - nearestData.minDistance + 0.001f;
-		const float normalX = m.normal.x;
-		const float normalY = m.normal.y;
+		return b2Vec2_zero;
+	}
 
-		float sepX = 0.0f;
-		float sepY = 0.0f;
-		float direction;
+	return CarromBody_GetPosition(state, index);
+}
 
-		if (tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top)
-		{
-			// should move horizontally
-			if (normalX == 0.0f)
-			{
-				// force move to right
-				direction = 1.0f;
-			}
-			else
-			{
-				direction = normalX > 0.0f ? -1.0f : 1.0f;
-			}
+bool CarromGameState_IsPuckEnabled(const CarromGameState* state, const int index)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
+	if (state == NULL)
+	{
+		return false;
+	}
 
-			if (pushOut < 0.00001f || b2AbsFloat(normalX) < 0.00001f)
-			{
-				sepX = direction * 0.001f;
-			}
-			else
-			{
-				sepX = pushOut * normalX;
-			}
-		}
-		else
-		{
-			// should move vertically
-			if (normalY == 0.0f)
-			{
-				// force move to up
-				direction = 1.0f;
-			}
-			else
-			{
-				direction = normalY > 0.0f ? -1.0f : 1.0f;
-			}
+	return CarromBody_IsEnabled(state, index);
+}
 
-			if (pushOut < 0.00001f || b2AbsFloat(normalY) < 0.00001f)
-			{
-				sepY = direction * 0.001f;
-			}
-			else
-			{
-				sepY = pushOut * normalY;
-			}
-		}
+b2Vec2 CarromGameState_GetStrikerPosition(const CarromGameState* state)
+{
+	MACARON_ASSERT(state != NULL);
+	if (state == NULL)
+	{
+		return b2Vec2_zero;
+	}
+
+	return CarromBody_GetPosition(state, IDX_STRIKER);
+}
+
+/**
+ * Move a puck to the closest spot around pos where it overlaps no other puck and stays on the table,
+ * the spot is found in closed form and the body is moved once
+ */
+b2Vec2 CarromGameState_PlacePuck(const CarromGameState* state, const CarromObject* puck, const b2Vec2 pos)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(puck != NULL);
+	if (state == NULL || puck == NULL)
+	{
+		return b2Vec2_zero;
+	}
+
+	CarromPuckSet set;
+	CarromGameState_BuildPuckSet(state, puck->index, &set);
+
+	// keep the small gap the pucks were always placed with
+	const float r = state->puckPhysicsDef.radius;
+	const float clearance = 0.001f;
+	const b2Vec2 finalPos = CarromPuckSet_NearestFree(&set, pos, 2 * r + clearance, state->worldDef.width / 2 - r,
+	                                                  state->worldDef.height / 2 - r);
+
+	CarromBody_SetTransform(state, puck->index, finalPos, b2Rot_identity);
+
+	return finalPos;
+}
+
+b2Vec2 CarromGameState_PlacePuckToPos(const CarromGameState* state, const int index, const b2Vec2 pos)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
+	if (state == NULL)
+	{
+		return b2Vec2_zero;
+	}
+
+	return CarromGameState_PlacePuck(state, &state->objects[index], pos);
+}
+
+void CarromGameState_PlacePuckToPosUnsafe(const CarromGameState* state, const int index, const b2Vec2 pos, bool enable)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
 
-		b2Vec2 after;
-		after.x = finalPos.x + sepX;
-		after.y = finalPos.y + sepY;
+	CarromBody_SetTransform(state, index, pos, b2Rot_identity);
+	if (enable)
+	{
+		CarromBody_Enable(state, index);
+	}
+	else
+	{
+		CarromBody_Disable(state, index);
+	}
+}
+
+b2Vec2 CarromGameState_PlacePuckToCenter(const CarromGameState* state, const int index)
+{
+	MACARON_ASSERT(MACARON_IS_VALID_PUCK_IDX(index));
+
+	if (!CarromBody_IsEnabled(state, index))
+	{
+		CarromBody_SetTransform(state, index, b2Vec2_zero, b2Rot_identity);
+		return b2Vec2_zero;
+	}
+
+	return CarromGameState_PlacePuck(state, &state->objects[index], b2Vec2_zero);
+}
+
+FindNearestPuckData CarromGameState_FindStrikerNearestPuck(const CarromGameState* state, const b2Vec2 pos)
+{
+	CarromPuckSet set;
+	CarromGameState_BuildPuckSet(state, -1, &set);
 
-		after = CarromGameState_LimitStrikerPos(state, tablePos, after);
+	return CarromGameState_FindNearestInSet(state, &set, pos);
+}
+
+b2Vec2 CarromGameState_LimitStrikerPos(const CarromGameState* state, const CarromTablePosition tablePos, const b2Vec2 pos)
+{
+	return CarromLimitStrikerPos(&state->strikerLimitDef, tablePos, pos);
+}
 
-		b2Body_SetTransform(strikerBodyId, after, b2Rot_identity);
+void CarromGameState_EnableStriker(const CarromGameState* state)
+{
+	MACARON_ASSERT(state != NULL);
+	if (state == NULL)
+	{
+		return;
+	}
+	CarromBody_Enable(state, IDX_STRIKER);
+}
 
-		bool reversed = false;
-		const float step = state->strikerPhysicsDef.radius / 100.0f;
+void CarromGameState_DisableStriker(const CarromGameState* state)
+{
+	MACARON_ASSERT(state != NULL);
+	if (state == NULL)
+	{
+		return;
+	}
+	CarromBody_Disable(state, IDX_STRIKER);
+}
 
-		const float maxHorizontalRange = state->strikerLimitDef.width > 0.0f
-			                                 ? state->strikerLimitDef.width / 2
-			                                 : state->worldDef.width / 2;
-		const float maxVerticalRange = state->strikerLimitDef.width > 0.0f
-			                               ? state->strikerLimitDef.width / 2
-			                               : state->worldDef.height / 2;
+bool CarromGameState_IsStrikerEnabled(const CarromGameState* state)
+{
+	MACARON_ASSERT(state != NULL);
+	if (state == NULL)
+	{
+		return false;
+	}
+	return CarromBody_IsEnabled(state, IDX_STRIKER);
+}
 
-		while (true)
+/**
+ * Legal striker ranges along the baseline through origin, see CarromStrikerFreeIntervals
+ */
+static int CarromGameState_BaselineIntervals(const CarromGameState* state, const CarromTablePosition tablePos,
+                                             const b2Vec2 origin, CarromInterval* out)
+{
+	b2Vec2 pucks[PUCK_IDX_COUNT];
+	int numPucks = 0;
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
+	{
+		const int idx = sPuckIndexes[i];
+		if (CarromBody_IsEnabled(state, idx))
 		{
-			const b2Vec2 placePos = b2Body_GetPosition(strikerBodyId);
-			const FindNearestPuckData data = CarromGameState_FindStrikerNearestPuck(state, placePos);
-			if (!data.found || data.minDistance > strikerR + puckR)
-			{
-				return placePos;
-			}
+			pucks[numPucks++] = CarromBody_GetPosition(state, idx);
+		}
+	}
 
-			b2Vec2 newPos = placePos;
-			if (tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top)
-			{
-				newPos.x += step * direction;
-				if (newPos.x < -maxHorizontalRange)
-				{
-					newPos.x = -maxHorizontalRange;
-					if (reversed)
-					{
-						return newPos;
-					}
-					direction = -direction;
-					reversed = true;
-					newPos = after;
-				}
-				else if (newPos.x > maxHorizontalRange)
-				{
-					newPos.x = maxHorizontalRange;
-					if (reversed)
-					{
-						return newPos;
-					}
-					direction = -direction;
-					reversed = true;
-					newPos = after;
-				}
-			}
-			else if (tablePos == CarromTablePosition_Left || tablePos == CarromTablePosition_Right)
-			{
-				newPos.y += step * direction;
-				if (newPos.y < -maxVerticalRange)
-				{
-					newPos.y = -maxVerticalRange;
-					if (reversed)
-					{
-						return newPos;
-					}
-					direction = -direction;
-					reversed = true;
-					newPos = after;
-				}
-				else if (newPos.y > maxVerticalRange)
-				{
-					newPos.y = maxVerticalRange;
-					if (reversed)
-					{
-						return newPos;
-					}
-					direction = -direction;
-					reversed = true;
-					newPos = after;
-				}
-			}
+	const float strikerR = state->strikerPhysicsDef.radius;
+	const float puckR = state->puckPhysicsDef.radius;
+	const float halfWidth = CarromStrikerBaselineHalfWidth(&state->worldDef, &state->strikerLimitDef, strikerR, tablePos);
+
+	return CarromStrikerFreeIntervals(pucks, numPucks, tablePos, origin, halfWidth, strikerR + puckR, out);
+}
+
+int CarromGameState_StrikerFreeIntervals(const CarromGameState* state, const CarromTablePosition tablePos,
+                                         CarromInterval* out)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(out != NULL);
+	if (state == NULL || out == NULL)
+	{
+		return 0;
+	}
 
-			b2Body_SetTransform(strikerBodyId, newPos, b2Rot_identity);
+	const b2Vec2 origin = CarromGameState_LimitStrikerPos(state, tablePos, b2Vec2_zero);
+	return CarromGameState_BaselineIntervals(state, tablePos, origin, out);
+}
+
+b2Vec2 CarromGameState_PlaceStriker(const CarromGameState* state, const CarromTablePosition tablePos, const b2Vec2 pos)
+{
+	b2Vec2 finalPos = CarromGameState_LimitStrikerPos(state, tablePos, pos);
+
+	CarromInterval intervals[MAX_STRIKER_INTERVALS];
+	const int count = CarromGameState_BaselineIntervals(state, tablePos, finalPos, intervals);
+
+	// a fully blocked baseline keeps the requested spot, overlapping a puck as documented in macaron.h
+	if (count > 0)
+	{
+		// same small gap as the pucks keep between them
+		const float clearance = 0.001f;
+		if (tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top)
+		{
+			finalPos.x = CarromSnapToIntervals(intervals, count, finalPos.x, clearance);
+		}
+		else
+		{
+			finalPos.y = CarromSnapToIntervals(intervals, count, finalPos.y, clearance);
 		}
 	}
 
-	return pos;
+	CarromBody_SetTransform(state, IDX_STRIKER, finalPos, b2Rot_identity);
+
+	return finalPos;
 }
 
 void CarromGameState_PlaceStrikerUnsafe(const CarromGameState* state, const b2Vec2 pos)
@@ -777,8 +1040,7 @@ void CarromGameState_PlaceStrikerUnsafe(const CarromGameState* state, const b2Ve
 		return;
 	}
 
-	const b2BodyId strikerBodyId = state->objects[IDX_STRIKER].bodyId;
-	b2Body_SetTransform(strikerBodyId, pos, b2Rot_identity);
+	CarromBody_SetTransform(state, IDX_STRIKER, pos, b2Rot_identity);
 }
 
 bool CarromGameState_IsStrikerOverlapping(const CarromGameState* state, const b2Vec2 pos)
@@ -789,17 +1051,13 @@ bool CarromGameState_IsStrikerOverlapping(const CarromGameState* state, const b2
 		return false;
 	}
 
-	const FindNearestPuckData data = CarromGameState_FindStrikerNearestPuck(state, pos);
+	CarromPuckSet set;
+	CarromGameState_BuildPuckSet(state, -1, &set);
 
 	const float strikerR = state->strikerPhysicsDef.radius;
 	const float puckR = state->puckPhysicsDef.radius;
 
-	if (data.found && data.minDistance < strikerR + puckR)
-	{
-		return true;
-	}
-
-	return false;
+	return CarromPuckSet_Overlaps(&set, pos, strikerR + puckR);
 }
 
 void CarromGameState_Strike(const CarromGameState* state, b2Vec2 impulse, const float maxForce)
@@ -810,19 +1068,17 @@ void CarromGameState_Strike(const CarromGameState* state, b2Vec2 impulse, const
 		return;
 	}
 
-	const b2BodyId strikerBodyId = state->objects[IDX_STRIKER].bodyId;
-
 	const float force = b2Length(impulse);
 	if (maxForce > 0.0f && force > maxForce)
 	{
 		const float scale = maxForce / force;
 		impulse = b2MulSV(scale, impulse);
 	}
-	if (!b2Body_IsEnabled(strikerBodyId))
+	if (!CarromBody_IsEnabled(state, IDX_STRIKER))
 	{
-		b2Body_Enable(strikerBodyId);
+		CarromBody_Enable(state, IDX_STRIKER);
 	}
-	b2Body_ApplyForceToCenter(strikerBodyId, impulse, true);
+	CarromBody_ApplyForce(state, IDX_STRIKER, impulse);
 }
 
 void CarromGameState_ApplyVelocityToStriker(const CarromGameState* state, const b2Vec2 velocity)
@@ -833,25 +1089,23 @@ void CarromGameState_ApplyVelocityToStriker(const CarromGameState* state, const
 		return;
 	}
 
-	const b2BodyId strikerBodyId = state->objects[IDX_STRIKER].bodyId;
-	b2Body_Enable(strikerBodyId);
-	b2Body_SetLinearVelocity(strikerBodyId, velocity);
+	CarromBody_Enable(state, IDX_STRIKER);
+	CarromBody_SetLinearVelocity(state, IDX_STRIKER, velocity);
 }
 
 CarromFrame CarromGameState_TakeSnapshot(const CarromGameState* state)
 {
 	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(b2World_IsValid(state->worldId));
+	MACARON_ASSERT(CarromEngine_IsValid(state));
 
 	CarromFrame frame = {0};
 	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		const CarromObject* obj = &state->objects[i];
-		if (!B2_ID_EQUALS(b2_nullBodyId, obj->bodyId))
+		if (CarromBody_Exists(state, i))
 		{
 			frame.snapshots[i].index = (int8_t)i;
-			frame.snapshots[i].enable = b2Body_IsEnabled(obj->bodyId);
-			frame.snapshots[i].position = b2Body_GetPosition(obj->bodyId);
+			frame.snapshots[i].enable = CarromBody_IsEnabled(state, i);
+			frame.snapshots[i].position = CarromBody_GetPosition(state, i);
 		}
 	}
 
@@ -869,7 +1123,7 @@ void CarromGameState_ApplySnapshot(CarromGameState* state, const CarromFrame* fr
 
 	if (recreate)
 	{
-		b2DestroyWorld(state->worldId);
+		CarromEngine_Destroy(state);
 		CarromGameState_CreateImpl(state,
 		                           &state->worldDef,
 		                           &state->pocketDef,
@@ -882,10 +1136,9 @@ void CarromGameState_ApplySnapshot(CarromGameState* state, const CarromFrame* fr
 	// disable all objects
 	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		const b2BodyId bodyId = state->objects[i].bodyId;
-		if (!B2_ID_EQUALS(bodyId, b2_nullBodyId))
+		if (CarromBody_Exists(state, i))
 		{
-			b2Body_Disable(bodyId);
+			CarromBody_Disable(state, i);
 		}
 	}
 
@@ -895,223 +1148,398 @@ void CarromGameState_ApplySnapshot(CarromGameState* state, const CarromFrame* fr
 		const CarromObjectSnapshot* objectSnapshot = &frame->snapshots[i];
 		if (MACARON_IS_VALID_OBJ_IDX(objectSnapshot->index))
 		{
-			const CarromObject* object = &state->objects[objectSnapshot->index];
 			if (objectSnapshot->enable)
 			{
-				b2Body_Enable(object->bodyId);
+				CarromBody_Enable(state, objectSnapshot->index);
 			}
-			b2Body_SetTransform(object->bodyId, objectSnapshot->position, b2Rot_identity);
+			CarromBody_SetTransform(state, objectSnapshot->index, objectSnapshot->position, b2Rot_identity);
 		}
 	}
 }
 
-/**
- * NOTE: WE ASSUME THAT THERE ARE ONLY TWO TYPES OF MOVING OBJECTS:
- * 1. STRIKER
- * 2. PUCK
- * ANY OTHER OBJECTS SHOULD NOT BE DYNAMIC
- *
- * @param state Game state
- * @param frame Output frame
- * @param pucksHitPocket number of pucks hit pocket
- */
-void CarromGameState_DumpSingleFrame(const CarromGameState* state, CarromFrame* frame, int8_t* pucksHitPocket)
+CarromFullSnapshot CarromGameState_TakeFullSnapshot(const CarromGameState* state, const int pucksHitPocket,
+                                                    const bool strikerHitPocket)
 {
-	// striker body id
-	const b2BodyId strikerBodyId = state->objects[IDX_STRIKER].bodyId;
+	MACARON_ASSERT(state != NULL);
 
-	// dump all objects first
-	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	CarromFullSnapshot snapshot = {0};
+	if (state == NULL)
 	{
-		CarromObjectSnapshot* snapshot = &frame->snapshots[i];
-		const b2BodyId objectBodyId = state->objects[i].bodyId;
-		if (!B2_ID_EQUALS(objectBodyId, b2_nullBodyId))
-		{
-			snapshot->index = (int8_t)i;
-			snapshot->enable = b2Body_IsEnabled(objectBodyId);
-			snapshot->position = b2Body_GetPosition(objectBodyId);
-			snapshot->hitEvent = CarromHitEventType_None;
-
-			// first frame, all objects are considered as moving
-			snapshot->rest = frame->index != 0;
-		}
-		else
-		{
-			snapshot->index = -1;
-		}
+		return snapshot;
 	}
 
-	// sensor events
-	const b2SensorEvents sensorEvents = b2World_GetSensorEvents(state->worldId);
-	if (sensorEvents.beginCount > 0)
-	{
-		for (int i = 0; i < sensorEvents.beginCount; i++)
-		{
-			const b2SensorBeginTouchEvent* sensorEvent = &sensorEvents.beginEvents[i];
-			const b2ShapeId sensorShapeId = sensorEvent->sensorShapeId;
-			const b2BodyId sensorBodyId = b2Shape_GetBody(sensorShapeId);
-
-			if (!B2_ID_EQUALS(sensorBodyId, state->wallBodyId))
-			{
-				continue;
-			}
+	MACARON_ASSERT(CarromEngine_IsValid(state));
 
-			const b2ShapeId visitorId = sensorEvent->visitorShapeId;
-			const b2BodyId bodyId = b2Shape_GetBody(visitorId);
+	snapshot.strikerHitPocket = strikerHitPocket;
+	snapshot.pucksHitPocket = (int8_t)pucksHitPocket;
 
-			const int32_t objectIndex = (int32_t)(intptr_t)b2Body_GetUserData(bodyId);
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		CarromObjectFullSnapshot* objectSnapshot = &snapshot.objects[i];
+		if (!CarromBody_Exists(state, i))
+		{
+			objectSnapshot->index = -1;
+			continue;
+		}
 
-			b2Body_Disable(bodyId);
+		objectSnapshot->index = (int8_t)i;
+		objectSnapshot->enable = CarromBody_IsEnabled(state, i);
+		objectSnapshot->awake = CarromBody_IsAwake(state, i);
+		objectSnapshot->position = CarromBody_GetPosition(state, i);
+		objectSnapshot->rotation = CarromBody_GetRotation(state, i);
+		objectSnapshot->linearVelocity = CarromBody_GetLinearVelocity(state, i);
+		objectSnapshot->angularVelocity = CarromBody_GetAngularVelocity(state, i);
+	}
 
-			if (objectIndex == IDX_STRIKER)
-			{
-				frame->strikerHitPocket = true;
-			}
+	return snapshot;
+}
 
-			(*pucksHitPocket)++;
-			frame->pucksHitPocket = *pucksHitPocket;
-			frame->snapshots[objectIndex].hitPocketIndex = *pucksHitPocket;
-			frame->snapshots[objectIndex].enable = false;
-			frame->snapshots[objectIndex].hitPocket = true;
-			frame->snapshots[objectIndex].hitEvent = CarromHitEventType_HitPocket;
-		}
+void CarromGameState_RestoreFullSnapshot(const CarromGameState* state, const CarromFullSnapshot* snapshot)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(snapshot != NULL);
+	if (state == NULL || snapshot == NULL)
+	{
+		return;
 	}
 
-	// dump contacts
-	const b2ContactEvents contactEvents = b2World_GetContactEvents(state->worldId);
-	if (contactEvents.beginCount > 0)
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		for (int i = 0; i < contactEvents.beginCount; i++)
+		const CarromObjectFullSnapshot* objectSnapshot = &snapshot->objects[i];
+		if (objectSnapshot->index != i || !CarromBody_Exists(state, i))
 		{
-			const b2ContactBeginTouchEvent* contactEvent = &contactEvents.beginEvents[i];
-			const b2ShapeId shapeIdA = contactEvent->shapeIdA;
-			const b2ShapeId shapeIdB = contactEvent->shapeIdB;
-
-			const b2BodyId bodyIdA = b2Shape_GetBody(shapeIdA);
-			const b2BodyId bodyIdB = b2Shape_GetBody(shapeIdB);
-
-			// case 1, striker hits the wall
-			// case 2, puck hits the wall
-			// case 3, striker hits the puck
-			// case 4, puck hits the puck
+			continue;
+		}
 
-			if (B2_ID_EQUALS(bodyIdA, state->wallBodyId) || B2_ID_EQUALS(bodyIdB, state->wallBodyId))
-			{
-				// wall
-				if (B2_ID_EQUALS(bodyIdA, strikerBodyId) || B2_ID_EQUALS(bodyIdB, strikerBodyId))
-				{
-					// striker hits the wall
-					if (frame->snapshots[IDX_STRIKER].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[IDX_STRIKER].hitEvent = CarromHitEventType_HitWall;
-					}
-				}
-				else
-				{
-					// puck hits the wall
-					b2BodyId puckBodyId;
-					if (!B2_ID_EQUALS(bodyIdA, state->wallBodyId))
-					{
-						puckBodyId = bodyIdA;
-					}
-					else
-					{
-						puckBodyId = bodyIdB;
-					}
-					const int32_t puckIndex = (int32_t)(intptr_t)b2Body_GetUserData(puckBodyId);
-					if (frame->snapshots[puckIndex].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[puckIndex].hitEvent = CarromHitEventType_HitWall;
-					}
-				}
-			}
-			else
+		// disabled bodies keep the recorded transform too, a later enable puts them back there
+		if (!objectSnapshot->enable)
+		{
+			if (CarromBody_IsEnabled(state, i))
 			{
-				if (B2_ID_EQUALS(bodyIdA, strikerBodyId) || B2_ID_EQUALS(bodyIdB, strikerBodyId))
-				{
-					// striker hits the puck
-					b2BodyId puckBodyId;
-					if (B2_ID_EQUALS(bodyIdA, strikerBodyId))
-					{
-						puckBodyId = bodyIdB;
-					}
-					else
-					{
-						puckBodyId = bodyIdA;
-					}
-					const int32_t otherIndex = (int32_t)(intptr_t)b2Body_GetUserData(puckBodyId);
-					if (frame->snapshots[IDX_STRIKER].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[IDX_STRIKER].hitEvent = CarromHitEventType_HitPuck;
-					}
-					if (frame->snapshots[otherIndex].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[otherIndex].hitEvent = CarromHitEventType_HitPuck;
-					}
-				}
-				else
-				{
-					// puck hits the puck
-					const int32_t puckIndexA = (int32_t)(intptr_t)b2Body_GetUserData(bodyIdA);
-					const int32_t puckIndexB = (int32_t)(intptr_t)b2Body_GetUserData(bodyIdB);
-					if (frame->snapshots[puckIndexA].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[puckIndexA].hitEvent = CarromHitEventType_HitPuck;
-					}
-					if (frame->snapshots[puckIndexB].hitEvent == CarromHitEventType_None)
-					{
-						frame->snapshots[puckIndexB].hitEvent = CarromHitEventType_HitPuck;
-					}
-				}
+				CarromBody_Disable(state, i);
 			}
+			CarromBody_SetTransform(state, i, objectSnapshot->position, objectSnapshot->rotation);
+			continue;
 		}
-	}
 
-	// dump movements
-	const b2BodyEvents bodyEvents = b2World_GetBodyEvents(state->worldId);
-	if (bodyEvents.moveCount > 0)
-	{
-		for (int i = 0; i < bodyEvents.moveCount; i++)
+		if (!CarromBody_IsEnabled(state, i))
 		{
-			const b2BodyMoveEvent* bodyMoveEvent = &bodyEvents.moveEvents[i];
-			const int32_t idx = (int32_t)(intptr_t)b2Body_GetUserData(bodyMoveEvent->bodyId);
-			if (idx >= 0 && idx < NUM_OF_OBJECTS)
-			{
-				frame->snapshots[idx].position = bodyMoveEvent->transform.p;
-				frame->snapshots[idx].rest = false;
-			}
+			CarromBody_Enable(state, i);
 		}
+
+		CarromBody_SetTransform(state, i, objectSnapshot->position, objectSnapshot->rotation);
+		CarromBody_SetLinearVelocity(state, i, objectSnapshot->linearVelocity);
+		CarromBody_SetAngularVelocity(state, i, objectSnapshot->angularVelocity);
+
+		// setting velocities wakes the body up, restore sleep state last
+		CarromBody_SetAwake(state, i, objectSnapshot->awake);
 	}
 }
 
-CarromEvalResult CarromGameState_Eval(const CarromGameState* state, const int maxSteps)
+int CarromGameState_Fork(const CarromGameState* state, const int count, CarromGameState* const* outStates)
 {
 	MACARON_ASSERT(state != NULL);
-	MACARON_ASSERT(maxSteps <= MAX_FRAME_CAPACITY);
-	MACARON_ASSERT(b2World_IsValid(state->worldId));
-
+	MACARON_ASSERT(count >= 0);
+	MACARON_ASSERT(outStates != NULL);
+	if (state == NULL || count <= 0 || outStates == NULL)
+	{
+		return 0;
+	}
+
+	const CarromFullSnapshot snapshot = CarromGameState_TakeFullSnapshot(state, 0, false);
+
+	int forked = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const CarromGameState* outState = outStates[i];
+		MACARON_ASSERT(outState != NULL);
+		if (outState == NULL)
+		{
+			continue;
+		}
+
+		// forking into the source itself is a no-op
+		const bool sameWorld = state->discWorld != NULL
+			                       ? outState->discWorld == state->discWorld
+			                       : outState->worldId.index1 == state->worldId.index1
+			                         && outState->worldId.revision == state->worldId.revision;
+		if (sameWorld)
+		{
+			continue;
+		}
+
+		// a pool built from another def, or a state whose disc world fell back to Box2D, can not take the copy
+		if (outState->worldDef.engine != state->worldDef.engine || !CarromEngine_IsValid(outState))
+		{
+			continue;
+		}
+
+		CarromGameState_RestoreFullSnapshot(outState, &snapshot);
+		// a strike pending for the next step and the rest timers are not part of the snapshot
+		CarromEngine_CopyPending(state, outState);
+		forked++;
+	}
+
+	return forked;
+}
+
+void CarromGameState_Reset(const CarromGameState* state, const CarromFrame* frame)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(frame != NULL);
+	if (state == NULL || frame == NULL)
+	{
+		return;
+	}
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (!CarromBody_Exists(state, i))
+		{
+			continue;
+		}
+
+		const CarromObjectSnapshot* objectSnapshot = &frame->snapshots[i];
+		const bool enable = objectSnapshot->index == i && objectSnapshot->enable;
+
+		if (!enable)
+		{
+			if (CarromBody_IsEnabled(state, i))
+			{
+				CarromBody_Disable(state, i);
+			}
+			continue;
+		}
+
+		if (!CarromBody_IsEnabled(state, i))
+		{
+			CarromBody_Enable(state, i);
+		}
+		CarromBody_SetTransform(state, i, objectSnapshot->position, b2Rot_identity);
+		CarromBody_SetLinearVelocity(state, i, b2Vec2_zero);
+		CarromBody_SetAngularVelocity(state, i, 0.0f);
+	}
+}
+
+/**
+ * Collect objects which entered a pocket during the last step and disable them
+ *
+ * @param state Game state
+ * @param objectIndexes Output object indexes, capacity should be NUM_OF_OBJECTS
+ * @param pocketIndexes Output pocket indexes, capacity should be NUM_OF_OBJECTS, can be NULL
+ *
+ * @return number of objects pocketed
+ */
+int CarromGameState_CollectPocketed(const CarromGameState* state, int8_t* objectIndexes, int8_t* pocketIndexes)
+{
+	const int count = CarromEngine_GetPocketed(state, objectIndexes, pocketIndexes);
+	for (int i = 0; i < count; i++)
+	{
+		CarromBody_Disable(state, objectIndexes[i]);
+	}
+
+	return count;
+}
+
+/**
+ * NOTE: WE ASSUME THAT THERE ARE ONLY TWO TYPES OF MOVING OBJECTS:
+ * 1. STRIKER
+ * 2. PUCK
+ * ANY OTHER OBJECTS SHOULD NOT BE DYNAMIC
+ *
+ * @param state Game state
+ * @param frame Output frame
+ * @param pucksHitPocket number of pucks hit pocket
+ */
+void CarromGameState_DumpSingleFrame(const CarromGameState* state, CarromFrame* frame, int8_t* pucksHitPocket)
+{
+	// dump all objects first
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		CarromObjectSnapshot* snapshot = &frame->snapshots[i];
+		if (CarromBody_Exists(state, i))
+		{
+			snapshot->index = (int8_t)i;
+			snapshot->enable = CarromBody_IsEnabled(state, i);
+			snapshot->position = CarromBody_GetPosition(state, i);
+			snapshot->hitEvent = CarromHitEventType_None;
+
+			// first frame, all objects are considered as moving
+			snapshot->rest = frame->index != 0;
+		}
+		else
+		{
+			snapshot->index = -1;
+		}
+	}
+
+	// movements, read before pocketed bodies get disabled
+	const uint32_t movedMask = CarromEngine_GetMovedMask(state);
+
+	// sensor events
+	int8_t pocketedObjects[NUM_OF_OBJECTS];
+	const int numPocketed = CarromGameState_CollectPocketed(state, pocketedObjects, NULL);
+	for (int i = 0; i < numPocketed; i++)
+	{
+		const int32_t objectIndex = pocketedObjects[i];
+
+		if (objectIndex == IDX_STRIKER)
+		{
+			frame->strikerHitPocket = true;
+		}
+
+		(*pucksHitPocket)++;
+		frame->pucksHitPocket = *pucksHitPocket;
+		frame->snapshots[objectIndex].hitPocketIndex = *pucksHitPocket;
+		frame->snapshots[objectIndex].enable = false;
+		frame->snapshots[objectIndex].hitPocket = true;
+		frame->snapshots[objectIndex].hitEvent = CarromHitEventType_HitPocket;
+	}
+
+	// dump contacts
+	int8_t contactA[DISC_MAX_CONTACT_EVENTS];
+	int8_t contactB[DISC_MAX_CONTACT_EVENTS];
+	const int numContacts = CarromEngine_GetContacts(state, contactA, contactB, DISC_MAX_CONTACT_EVENTS);
+	for (int i = 0; i < numContacts; i++)
+	{
+		const int32_t indexA = contactA[i];
+		const int32_t indexB = contactB[i];
+
+		// case 1, striker or puck hits the wall
+		// case 2, striker or puck hits another puck
+		if (indexA == IDX_WALL || indexB == IDX_WALL)
+		{
+			const int32_t objectIndex = indexA == IDX_WALL ? indexB : indexA;
+			if (MACARON_IS_VALID_OBJ_IDX(objectIndex)
+			    && frame->snapshots[objectIndex].hitEvent == CarromHitEventType_None)
+			{
+				frame->snapshots[objectIndex].hitEvent = CarromHitEventType_HitWall;
+			}
+			continue;
+		}
+
+		if (MACARON_IS_VALID_OBJ_IDX(indexA) && frame->snapshots[indexA].hitEvent == CarromHitEventType_None)
+		{
+			frame->snapshots[indexA].hitEvent = CarromHitEventType_HitPuck;
+		}
+		if (MACARON_IS_VALID_OBJ_IDX(indexB) && frame->snapshots[indexB].hitEvent == CarromHitEventType_None)
+		{
+			frame->snapshots[indexB].hitEvent = CarromHitEventType_HitPuck;
+		}
+	}
+
+	// dump movements
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((movedMask & MACARON_OBJ_BIT(i)) != 0)
+		{
+			frame->snapshots[i].position = CarromBody_GetPosition(state, i);
+			frame->snapshots[i].rest = false;
+		}
+	}
+}
+
+/**
+ * Step the world once and dump the result into the frame
+ *
+ * @param state Game state
+ * @param frame Output frame, should be cleared by the caller
+ * @param pucksHitPocket number of pucks hit pocket
+ * @param clock stepping state, see CarromGameState_UpdateRest
+ *
+ * @return true if there are still movements
+ */
+bool CarromGameState_StepAndDump(const CarromGameState* state, CarromFrame* frame, int8_t* pucksHitPocket,
+                                 CarromStepClock* clock)
+{
+	const float dt = CarromGameState_StepFrame(state, false);
+	clock->time += dt;
+
+	CarromGameState_DumpSingleFrame(state, frame, pucksHitPocket);
+	frame->time = clock->time;
+
+	if (!CarromGameState_UpdateRest(state, clock, dt))
+	{
+		// disable striker
+		CarromBody_Disable(state, IDX_STRIKER);
+
+		return false;
+	}
+
+	return true;
+}
+
+CarromEvalResult CarromGameState_Eval(const CarromGameState* state, const int maxSteps)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(maxSteps <= MAX_FRAME_CAPACITY);
+	MACARON_ASSERT(CarromEngine_IsValid(state));
+
 	CarromEvalResult result = {0};
 
 	const int caps = maxSteps == 0 ? MAX_FRAME_CAPACITY : maxSteps;
 
+	CarromStepClock clock = {0};
+
 	while (result.numFrames < caps)
 	{
-		b2World_Step(state->worldId, state->worldDef.frameDuration, state->worldDef.subStep);
-
 		// dump frame
 		CarromFrame* frame = &result.frames[result.numFrames];
 		frame->index = result.numFrames;
 
-		CarromGameState_DumpSingleFrame(state, frame, &result.pucksHitPocket);
+		const bool moving = CarromGameState_StepAndDump(state, frame, &result.pucksHitPocket, &clock);
 
 		result.strikerHitPocket |= frame->strikerHitPocket;
 		result.numFrames++;
 
-		if (!CarromGameState_HasMovement(state))
+		if (!moving)
 		{
-			// disable striker
-			b2Body_Disable(state->objects[IDX_STRIKER].bodyId);
+			break;
+		}
+	}
+
+	return result;
+}
+
+CarromEvalStreamResult CarromGameState_EvalStream(const CarromGameState* state, const int maxSteps,
+                                                  CarromFrameSinkFcn* sink, void* userData)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(maxSteps >= 0 && maxSteps <= INT16_MAX);
 
+	CarromEvalStreamResult result = {0};
+	if (state == NULL)
+	{
+		return result;
+	}
+
+	MACARON_ASSERT(CarromEngine_IsValid(state));
+
+	const int caps = maxSteps == 0 ? MAX_FRAME_CAPACITY : maxSteps;
+
+	// single frame of scratch, reused for every step
+	CarromFrame frame;
+
+	CarromStepClock clock = {0};
+
+	while (result.numFrames < caps)
+	{
+		frame = (CarromFrame){0};
+		frame.index = result.numFrames;
+
+		const bool moving = CarromGameState_StepAndDump(state, &frame, &result.pucksHitPocket, &clock);
+
+		result.strikerHitPocket |= frame.strikerHitPocket;
+		result.numFrames++;
+
+		if (sink != NULL && !sink(&frame, userData))
+		{
+			result.stopped = moving;
+			break;
+		}
+
+		if (!moving)
+		{
 			break;
 		}
 	}
@@ -1119,17 +1547,330 @@ CarromEvalResult CarromGameState_Eval(const CarromGameState* state, const int ma
 	return result;
 }
 
-void CarromGameState_Destroy(CarromGameState* state)
+int CarromGameState_EvalInto(const CarromGameState* state, const int maxSteps, CarromTrajectory* trajectory)
 {
 	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(trajectory != NULL);
+	MACARON_ASSERT(maxSteps >= 0 && maxSteps <= INT16_MAX);
+	if (state == NULL || trajectory == NULL)
+	{
+		return 0;
+	}
+
+	MACARON_ASSERT(CarromEngine_IsValid(state));
+
+	trajectory->strikerHitPocket = false;
+	trajectory->pucksHitPocket = 0;
+	trajectory->numFrames = 0;
+
+	const int caps = maxSteps == 0 ? INT16_MAX : maxSteps;
+
+	CarromStepClock clock = {0};
+
+	while (trajectory->numFrames < caps)
+	{
+		if (trajectory->numFrames == trajectory->capacity)
+		{
+			const int capacity = trajectory->capacity == 0 ? MAX_FRAME_CAPACITY : trajectory->capacity * 2;
+			if (!CarromTrajectory_Reserve(trajectory, capacity < caps ? capacity : caps))
+			{
+				break;
+			}
+		}
+
+		// clear only the frame in use
+		CarromFrame* frame = &trajectory->frames[trajectory->numFrames];
+		*frame = (CarromFrame){0};
+		frame->index = (int16_t)trajectory->numFrames;
+
+		const bool moving = CarromGameState_StepAndDump(state, frame, &trajectory->pucksHitPocket, &clock);
+
+		trajectory->strikerHitPocket |= frame->strikerHitPocket;
+		trajectory->numFrames++;
+
+		if (!moving)
+		{
+			break;
+		}
+	}
+
+	return trajectory->numFrames;
+}
+
+/**
+ * Distance a body still travels under linear damping alone,
+ * the per step damping of Box2D sums up to speed / damping whatever the step size
+ */
+static float CarromGameState_RemainingDistance(const float speed, const float damping)
+{
+	if (speed == 0.0f)
+	{
+		return 0.0f;
+	}
+
+	return damping > 0.0f ? speed / damping : FLT_MAX;
+}
+
+/**
+ * Fold a coordinate travelled in a straight line back into [-limit, limit], each crossing is a cushion bounce
+ */
+static float CarromGameState_FoldOffWalls(const float x, const float limit)
+{
+	if (limit <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// the unfolded path repeats every two bounces
+	const float period = 4 * limit;
+	float folded = fmodf(x + limit, period);
+	folded = folded < 0.0f ? folded + period : folded;
+	folded = folded > 2 * limit ? period - folded : folded;
+	return folded - limit;
+}
+
+static float CarromGameState_MaxSpeed(const CarromGameState* state)
+{
+	float maxSpeed = 0.0f;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (!CarromBody_Exists(state, i) || !CarromBody_IsEnabled(state, i) || !CarromBody_IsAwake(state, i))
+		{
+			continue;
+		}
+
+		maxSpeed = b2MaxFloat(maxSpeed, b2Length(CarromBody_GetLinearVelocity(state, i)));
+	}
+
+	return maxSpeed;
+}
+
+/**
+ * Conservative reachability test, every moving body may travel its remaining distance in any direction,
+ * cushions only fold the path and are ignored
+ *
+ * @return true if some moving body may still enter a pocket or touch another body
+ */
+static bool CarromGameState_CanReachContact(const CarromGameState* state)
+{
+	b2Vec2 positions[NUM_OF_OBJECTS];
+	float reaches[NUM_OF_OBJECTS];
+	bool enables[NUM_OF_OBJECTS];
+
+	bool moving = false;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		enables[i] = CarromBody_Exists(state, i) && CarromBody_IsEnabled(state, i);
+		reaches[i] = 0.0f;
+		if (!enables[i])
+		{
+			continue;
+		}
+
+		positions[i] = CarromBody_GetPosition(state, i);
+		if (CarromBody_IsAwake(state, i))
+		{
+			const float speed = b2Length(CarromBody_GetLinearVelocity(state, i));
+			reaches[i] = CarromGameState_RemainingDistance(speed, CarromGameState_ObjectDamping(state, i));
+			moving |= reaches[i] > 0.0f;
+		}
+	}
+
+	if (!moving)
+	{
+		return false;
+	}
+
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	CarromPocketPositions(&state->worldDef, &state->pocketDef, pockets);
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (reaches[i] == 0.0f)
+		{
+			continue;
+		}
+
+		const float radius = CarromGameState_ObjectRadius(state, i);
+		for (int j = 0; j < MAX_POCKET_CAPACITY; j++)
+		{
+			if (b2Distance(positions[i], pockets[j]) - state->pocketDef.radius - radius <= reaches[i])
+			{
+				return true;
+			}
+		}
+
+		for (int j = 0; j < NUM_OF_OBJECTS; j++)
+		{
+			if (j == i || !enables[j])
+			{
+				continue;
+			}
+
+			const float gap = b2Distance(positions[i], positions[j]) - radius - CarromGameState_ObjectRadius(state, j);
+			if (gap <= reaches[i] + reaches[j])
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Check the stop conditions after a step
+ *
+ * @param firstPocketed first entry of outcome->pocketedOrder added by the last step
+ *
+ * @return true if the evaluation should stop, outcome->stopReason is set accordingly
+ */
+static bool CarromGameState_CheckStop(const CarromGameState* state, const CarromEvalStopDef* stopDef,
+                                      CarromEvalOutcome* outcome, const int firstPocketed)
+{
+	for (int i = firstPocketed; i < outcome->pucksHitPocket; i++)
+	{
+		const int8_t objectIndex = outcome->pocketedOrder[i];
+		if (stopDef->onStrikerPocketed && objectIndex == IDX_STRIKER)
+		{
+			outcome->stopReason = CarromEvalStopReason_StrikerPocketed;
+			return true;
+		}
+		if (stopDef->targetIndex >= 0 && objectIndex == stopDef->targetIndex)
+		{
+			outcome->stopReason = CarromEvalStopReason_TargetPocketed;
+			return true;
+		}
+	}
+
+	if (stopDef->numPucksPocketed > 0 && firstPocketed < outcome->pucksHitPocket)
+	{
+		const int numPucks = outcome->pucksHitPocket - (outcome->strikerHitPocket ? 1 : 0);
+		if (numPucks >= stopDef->numPucksPocketed)
+		{
+			outcome->stopReason = CarromEvalStopReason_PucksPocketed;
+			return true;
+		}
+	}
+
+	if (stopDef->minSpeed > 0.0f && CarromGameState_MaxSpeed(state) < stopDef->minSpeed)
+	{
+		outcome->stopReason = CarromEvalStopReason_MinSpeed;
+		return true;
+	}
+
+	if (stopDef->onNoReachableContact && !CarromGameState_CanReachContact(state))
+	{
+		outcome->stopReason = CarromEvalStopReason_NoReachableContact;
+		return true;
+	}
+
+	if (stopDef->customFcn != NULL && stopDef->customFcn(state, outcome, stopDef->userData))
+	{
+		outcome->stopReason = CarromEvalStopReason_Custom;
+		return true;
+	}
+
+	return false;
+}
+
+CarromEvalOutcome CarromGameState_EvalOutcome(const CarromGameState* state, const int maxSteps)
+{
+	return CarromGameState_EvalOutcomeUntil(state, maxSteps, NULL);
+}
+
+CarromEvalOutcome CarromGameState_EvalOutcomeUntil(const CarromGameState* state, const int maxSteps,
+                                                   const CarromEvalStopDef* stopDef)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(maxSteps >= 0 && maxSteps <= INT16_MAX);
+
+	CarromEvalOutcome outcome = {0};
 	if (state == NULL)
 	{
-		return;
+		return outcome;
 	}
 
-	if (b2World_IsValid(state->worldId))
+	MACARON_ASSERT(CarromEngine_IsValid(state));
+
+	const int caps = maxSteps == 0 ? MAX_FRAME_CAPACITY : maxSteps;
+
+	int8_t pocketedObjects[NUM_OF_OBJECTS];
+	int8_t pocketedPockets[NUM_OF_OBJECTS];
+	CarromStepClock clock = {0};
+
+	outcome.stopReason = CarromEvalStopReason_MaxSteps;
+	while (outcome.numFrames < caps)
 	{
-		b2DestroyWorld(state->worldId);
+		const float dt = CarromGameState_StepFrame(state, true);
+		outcome.numFrames++;
+		outcome.time += dt;
+
+		// only sensor events matter here
+		const int firstPocketed = outcome.pucksHitPocket;
+		const int numPocketed = CarromGameState_CollectPocketed(state, pocketedObjects, pocketedPockets);
+		for (int i = 0; i < numPocketed && outcome.pucksHitPocket < NUM_OF_OBJECTS; i++)
+		{
+			if (pocketedObjects[i] == IDX_STRIKER)
+			{
+				outcome.strikerHitPocket = true;
+			}
+
+			outcome.pocketedOrder[outcome.pucksHitPocket] = pocketedObjects[i];
+			outcome.pocketedPocket[outcome.pucksHitPocket] = pocketedPockets[i];
+			outcome.pucksHitPocket++;
+		}
+
+		if (!CarromGameState_UpdateRest(state, &clock, dt))
+		{
+			// disable striker
+			CarromBody_Disable(state, IDX_STRIKER);
+
+			outcome.stopReason = CarromEvalStopReason_Rest;
+			break;
+		}
+
+		if (stopDef != NULL && CarromGameState_CheckStop(state, stopDef, &outcome, firstPocketed))
+		{
+			break;
+		}
 	}
-	state->worldId = b2_nullWorldId;
+
+	// read positions once, at rest
+	const float limitX = state->worldDef.width / 2;
+	const float limitY = state->worldDef.height / 2;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if (!CarromBody_Exists(state, i))
+		{
+			continue;
+		}
+
+		outcome.enables[i] = CarromBody_IsEnabled(state, i);
+		outcome.positions[i] = CarromBody_GetPosition(state, i);
+
+		// nothing can touch anymore, bodies glide to where damping stops them and the elastic cushions reflect them
+		const float damping = CarromGameState_ObjectDamping(state, i);
+		if (outcome.stopReason == CarromEvalStopReason_NoReachableContact && outcome.enables[i] && damping > 0.0f)
+		{
+			const b2Vec2 velocity = CarromBody_GetLinearVelocity(state, i);
+			const float radius = CarromGameState_ObjectRadius(state, i);
+			const b2Vec2 position = b2MulAdd(outcome.positions[i], 1.0f / damping, velocity);
+			outcome.positions[i].x = CarromGameState_FoldOffWalls(position.x, limitX - radius);
+			outcome.positions[i].y = CarromGameState_FoldOffWalls(position.y, limitY - radius);
+		}
+	}
+
+	return outcome;
+}
+
+void CarromGameState_Destroy(CarromGameState* state)
+{
+	MACARON_ASSERT(state != NULL);
+	if (state == NULL)
+	{
+		return;
+	}
+
+	CarromEngine_Destroy(state);
 }
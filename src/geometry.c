@@ -0,0 +1,396 @@
+#include "core.h"
+#include "geometry.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+
+void CarromPocketPositions(const CarromWorldDef* worldDef, const CarromPocketDef* pocketDef,
+                           b2Vec2 positions[MAX_POCKET_CAPACITY])
+{
+	const float left = -worldDef->width / 2 + pocketDef->cornerOffsetX;
+	const float right = worldDef->width / 2 - pocketDef->cornerOffsetX;
+	const float top = worldDef->height / 2 - pocketDef->cornerOffsetY;
+	const float bottom = -worldDef->height / 2 + pocketDef->cornerOffsetY;
+
+	positions[0] = (b2Vec2){left, top};
+	positions[1] = (b2Vec2){right, top};
+	positions[2] = (b2Vec2){right, bottom};
+	positions[3] = (b2Vec2){left, bottom};
+}
+
+b2Vec2 CarromLimitStrikerPos(const CarromStrikerLimitDef* limitDef, const CarromTablePosition tablePos, const b2Vec2 pos)
+{
+	b2Vec2 finalPos = pos;
+
+	const float strikerLimitWidth = limitDef->width;
+	const float centerOffset = limitDef->centerOffset;
+
+	if (strikerLimitWidth == 0.0f || centerOffset == 0.0f)
+	{
+		return finalPos;
+	}
+
+	const float horizontalLeftX = -strikerLimitWidth / 2;
+	const float horizontalRightX = strikerLimitWidth / 2;
+	const float horizontalTopY = centerOffset;
+	const float horizontalBottomY = -centerOffset;
+	const float verticalTopY = strikerLimitWidth / 2;
+	const float verticalBottomY = -strikerLimitWidth / 2;
+	const float verticalLeftX = -centerOffset;
+	const float verticalRightX = centerOffset;
+
+	if (tablePos == CarromTablePosition_Bottom)
+	{
+		finalPos.y = horizontalBottomY;
+	}
+	else if (tablePos == CarromTablePosition_Left)
+	{
+		finalPos.x = verticalLeftX;
+	}
+	else if (tablePos == CarromTablePosition_Top)
+	{
+		finalPos.y = horizontalTopY;
+	}
+	else if (tablePos == CarromTablePosition_Right)
+	{
+		finalPos.x = verticalRightX;
+	}
+
+	if (tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top)
+	{
+		// limit x
+		if (finalPos.x < horizontalLeftX)
+		{
+			finalPos.x = horizontalLeftX;
+		}
+		if (finalPos.x > horizontalRightX)
+		{
+			finalPos.x = horizontalRightX;
+		}
+	}
+	else if (tablePos == CarromTablePosition_Left || tablePos == CarromTablePosition_Right)
+	{
+		// limit y
+		if (finalPos.y < verticalBottomY)
+		{
+			finalPos.y = verticalBottomY;
+		}
+		if (finalPos.y > verticalTopY)
+		{
+			finalPos.y = verticalTopY;
+		}
+	}
+
+	return finalPos;
+}
+
+float CarromStrikerBaselineHalfWidth(const CarromWorldDef* worldDef, const CarromStrikerLimitDef* limitDef,
+                                     const float strikerRadius, const CarromTablePosition tablePos)
+{
+	if (limitDef->width > 0.0f && limitDef->centerOffset != 0.0f)
+	{
+		return limitDef->width / 2;
+	}
+
+	const bool horizontal = tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top;
+	return (horizontal ? worldDef->width : worldDef->height) / 2 - strikerRadius;
+}
+
+static int CarromInterval_CompareMin(const void* a, const void* b)
+{
+	const float minA = ((const CarromInterval*)a)->min;
+	const float minB = ((const CarromInterval*)b)->min;
+	return (minA > minB) - (minA < minB);
+}
+
+int CarromStrikerFreeIntervals(const b2Vec2* pucks, const int numPucks, const CarromTablePosition tablePos,
+                               const b2Vec2 origin, const float halfWidth, const float distance, CarromInterval* out)
+{
+	const bool horizontal = tablePos == CarromTablePosition_Bottom || tablePos == CarromTablePosition_Top;
+	const float line = horizontal ? origin.y : origin.x;
+
+	// a puck at offset d from the baseline blocks the chord of the circle of radius distance around it
+	CarromInterval blocked[PUCK_IDX_COUNT];
+	int numBlocked = 0;
+	for (int i = 0; i < numPucks && numBlocked < PUCK_IDX_COUNT; i++)
+	{
+		const float d = (horizontal ? pucks[i].y : pucks[i].x) - line;
+		const float h = distance * distance - d * d;
+		if (h <= 0.0f)
+		{
+			continue;
+		}
+
+		const float s = horizontal ? pucks[i].x : pucks[i].y;
+		const float half = sqrtf(h);
+		blocked[numBlocked++] = (CarromInterval){s - half, s + half};
+	}
+
+	qsort(blocked, (size_t)numBlocked, sizeof(CarromInterval), CarromInterval_CompareMin);
+
+	// sweep the sorted chords, every gap between them is legal
+	int count = 0;
+	float start = -halfWidth;
+	for (int i = 0; i < numBlocked; i++)
+	{
+		if (blocked[i].min > start && start < halfWidth)
+		{
+			out[count++] = (CarromInterval){start, blocked[i].min < halfWidth ? blocked[i].min : halfWidth};
+		}
+		start = blocked[i].max > start ? blocked[i].max : start;
+	}
+
+	if (start < halfWidth)
+	{
+		out[count++] = (CarromInterval){start, halfWidth};
+	}
+
+	return count;
+}
+
+float CarromSnapToIntervals(const CarromInterval* intervals, const int count, const float s, const float margin)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (s >= intervals[i].min && s <= intervals[i].max)
+		{
+			return s;
+		}
+	}
+
+	float best = s;
+	float bestDistance = FLT_MAX;
+	for (int i = 0; i < count; i++)
+	{
+		const float gap = b2MinFloat(margin, (intervals[i].max - intervals[i].min) / 2);
+		const float snapped = b2ClampFloat(s, intervals[i].min + gap, intervals[i].max - gap);
+		const float distance = b2AbsFloat(snapped - s);
+		if (distance < bestDistance)
+		{
+			best = snapped;
+			bestDistance = distance;
+		}
+	}
+
+	return best;
+}
+
+void CarromTableGeometry_Init(CarromTableGeometry* geometry, const CarromGameDef* def, const CarromFrame* frame)
+{
+	geometry->numPucks = 0;
+	for (int i = 0; i < PUCK_IDX_COUNT; i++)
+	{
+		const int idx = sPuckIndexes[i];
+		const CarromObjectSnapshot* snapshot = &frame->snapshots[idx];
+		if (snapshot->index != idx || !snapshot->enable)
+		{
+			continue;
+		}
+
+		geometry->puckIndexes[geometry->numPucks] = (int8_t)idx;
+		geometry->pucks[geometry->numPucks] = snapshot->position;
+		geometry->numPucks++;
+	}
+
+	CarromPocketPositions(&def->worldDef, &def->pocketDef, geometry->pockets);
+	geometry->pocketRadius = def->pocketDef.radius;
+	geometry->puckRadius = def->puckPhysicsDef.radius;
+	geometry->strikerRadius = def->strikerPhysicsDef.radius;
+	geometry->halfWidth = def->worldDef.width / 2;
+	geometry->halfHeight = def->worldDef.height / 2;
+	geometry->strikerLimitDef = def->strikerLimitDef;
+}
+
+float CarromRayCircle(const b2Vec2 origin, const b2Vec2 direction, const b2Vec2 center, const float radius)
+{
+	const b2Vec2 d = b2Sub(center, origin);
+	const float t = b2Dot(d, direction);
+
+	// behind the origin or moving away, overlapping circles included, resting contacts overlap by the linear slop
+	if (t <= 0.0f)
+	{
+		return FLT_MAX;
+	}
+
+	const float rr = radius * radius;
+	const float dd = b2LengthSquared(d);
+	if (dd <= rr)
+	{
+		return 0.0f;
+	}
+
+	const float perp = dd - t * t;
+	if (perp >= rr)
+	{
+		return FLT_MAX;
+	}
+
+	return t - sqrtf(rr - perp);
+}
+
+float CarromRayWall(const CarromTableGeometry* geometry, const b2Vec2 origin, const b2Vec2 direction, const float radius)
+{
+	const float limitX = geometry->halfWidth - radius;
+	const float limitY = geometry->halfHeight - radius;
+
+	float t = FLT_MAX;
+	if (direction.x > 0.0f)
+	{
+		t = b2MinFloat(t, (limitX - origin.x) / direction.x);
+	}
+	else if (direction.x < 0.0f)
+	{
+		t = b2MinFloat(t, (-limitX - origin.x) / direction.x);
+	}
+	if (direction.y > 0.0f)
+	{
+		t = b2MinFloat(t, (limitY - origin.y) / direction.y);
+	}
+	else if (direction.y < 0.0f)
+	{
+		t = b2MinFloat(t, (-limitY - origin.y) / direction.y);
+	}
+
+	return b2MaxFloat(t, 0.0f);
+}
+
+CarromShotPrefilter CarromTableGeometry_Prefilter(const CarromTableGeometry* geometry, const CarromShot* shot)
+{
+	CarromShotPrefilter result = {CarromShotClass_Blocked, -1, -1};
+
+	const b2Vec2 strikerPos = CarromLimitStrikerPos(&geometry->strikerLimitDef, shot->tablePos, shot->strikerPos);
+	const b2Vec2 direction = b2Normalize(shot->impulse);
+	if (b2LengthSquared(direction) == 0.0f)
+	{
+		return result;
+	}
+
+	const float puckR = geometry->puckRadius;
+	const float strikerR = geometry->strikerRadius;
+
+	// striker corridor, first puck touched before the cushion
+	const float strikerWall = CarromRayWall(geometry, strikerPos, direction, strikerR);
+	float strikerHit = strikerWall;
+	int target = -1;
+	for (int i = 0; i < geometry->numPucks; i++)
+	{
+		const float t = CarromRayCircle(strikerPos, direction, geometry->pucks[i], puckR + strikerR);
+		if (t < strikerHit)
+		{
+			strikerHit = t;
+			target = i;
+		}
+	}
+
+	// striker falls into a pocket before touching anything
+	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+	{
+		if (CarromRayCircle(strikerPos, direction, geometry->pockets[i], geometry->pocketRadius + strikerR) < strikerHit)
+		{
+			return result;
+		}
+	}
+
+	// striker starts inside a puck ahead of it, its corridor is occluded from the baseline on
+	if (target >= 0 && strikerHit <= 0.0f)
+	{
+		result.targetIndex = geometry->puckIndexes[target];
+		return result;
+	}
+
+	// cushion first, banks are left to the simulation
+	result.shotClass = CarromShotClass_NeedsSim;
+	if (target < 0)
+	{
+		return result;
+	}
+
+	result.targetIndex = geometry->puckIndexes[target];
+
+	// target puck corridor, the puck leaves along the line of centers
+	const b2Vec2 targetPos = geometry->pucks[target];
+	const b2Vec2 contact = b2MulAdd(strikerPos, strikerHit, direction);
+	const b2Vec2 puckDirection = b2Normalize(b2Sub(targetPos, contact));
+
+	const float puckWall = CarromRayWall(geometry, targetPos, puckDirection, puckR);
+	float pocketHit = FLT_MAX;
+	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+	{
+		const float t = CarromRayCircle(targetPos, puckDirection, geometry->pockets[i], geometry->pocketRadius + puckR);
+		if (t < pocketHit && t <= puckWall)
+		{
+			pocketHit = t;
+			result.pocketIndex = (int8_t)i;
+		}
+	}
+
+	// heading into the cushion, indirect shots are left to the simulation
+	if (result.pocketIndex < 0)
+	{
+		return result;
+	}
+
+	// other pucks in the way to the pocket
+	for (int i = 0; i < geometry->numPucks; i++)
+	{
+		if (i == target)
+		{
+			continue;
+		}
+
+		if (CarromRayCircle(targetPos, puckDirection, geometry->pucks[i], puckR * 2) < pocketHit)
+		{
+			result.shotClass = CarromShotClass_Blocked;
+			return result;
+		}
+	}
+
+	result.shotClass = CarromShotClass_Clear;
+	return result;
+}
+
+CarromShotPrefilter CarromPrefilterShot(const CarromGameDef* def, const CarromFrame* frame, const CarromShot* shot)
+{
+	CarromShotPrefilter result = {CarromShotClass_NeedsSim, -1, -1};
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(frame != NULL);
+	MACARON_ASSERT(shot != NULL);
+	if (def == NULL || frame == NULL || shot == NULL)
+	{
+		return result;
+	}
+
+	CarromTableGeometry geometry;
+	CarromTableGeometry_Init(&geometry, def, frame);
+
+	return CarromTableGeometry_Prefilter(&geometry, shot);
+}
+
+int CarromPrefilterShots(const CarromGameDef* def, const CarromFrame* frame, const CarromShot* shots, const int count,
+                         CarromShotPrefilter* results)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(frame != NULL);
+	MACARON_ASSERT(shots != NULL);
+	MACARON_ASSERT(results != NULL);
+	if (def == NULL || frame == NULL || shots == NULL || results == NULL)
+	{
+		return 0;
+	}
+
+	CarromTableGeometry geometry;
+	CarromTableGeometry_Init(&geometry, def, frame);
+
+	int numCandidates = 0;
+	for (int i = 0; i < count; i++)
+	{
+		results[i] = CarromTableGeometry_Prefilter(&geometry, &shots[i]);
+		if (results[i].shotClass != CarromShotClass_Blocked)
+		{
+			numCandidates++;
+		}
+	}
+
+	return numCandidates;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <macaron/types.h>
+
+#include <float.h>
+
+// Table layout used by the pure geometry queries, no Box2D lookups involved
+typedef struct CarromTableGeometry
+{
+	// number of enabled pucks
+	int numPucks;
+	// enabled puck indexes
+	int8_t puckIndexes[PUCK_IDX_COUNT];
+	// enabled puck positions
+	b2Vec2 pucks[PUCK_IDX_COUNT];
+	// pocket centers
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	// pocket radius
+	float pocketRadius;
+	// puck radius
+	float puckRadius;
+	// striker radius
+	float strikerRadius;
+	// half of the world width
+	float halfWidth;
+	// half of the world height
+	float halfHeight;
+	// striker limit def
+	CarromStrikerLimitDef strikerLimitDef;
+
+} CarromTableGeometry;
+
+/**
+ * Compute the pocket centers, same order as CarromGameState.pockets
+ */
+void CarromPocketPositions(const CarromWorldDef* worldDef, const CarromPocketDef* pocketDef,
+                           b2Vec2 positions[MAX_POCKET_CAPACITY]);
+
+/**
+ * Clamp the striker position to the baseline of the table position
+ */
+b2Vec2 CarromLimitStrikerPos(const CarromStrikerLimitDef* limitDef, CarromTablePosition tablePos, b2Vec2 pos);
+
+/**
+ * Half length of the legal striker baseline, from the limit def or from the table side minus the striker
+ */
+float CarromStrikerBaselineHalfWidth(const CarromWorldDef* worldDef, const CarromStrikerLimitDef* limitDef,
+                                     float strikerRadius, CarromTablePosition tablePos);
+
+/**
+ * Legal striker ranges along the baseline through origin
+ *
+ * each puck closer to the baseline than distance removes one open interval, what is left is returned in increasing
+ * order, pucks are sorted once so the cost is O(n log n)
+ *
+ * @param origin any point of the baseline
+ * @param halfWidth the baseline spans [-halfWidth, halfWidth] along its axis
+ * @param out output intervals, capacity MAX_STRIKER_INTERVALS
+ *
+ * @return number of intervals, 0 if the whole baseline is blocked
+ */
+int CarromStrikerFreeIntervals(const b2Vec2* pucks, int numPucks, CarromTablePosition tablePos, b2Vec2 origin,
+                               float halfWidth, float distance, CarromInterval* out);
+
+/**
+ * Closest value to s inside the intervals, s itself when it is already inside one
+ *
+ * @param margin a snapped value stays this far from the interval ends, short intervals give their middle
+ */
+float CarromSnapToIntervals(const CarromInterval* intervals, int count, float s, float margin);
+
+/**
+ * Build table geometry from a frame, only enabled pucks are kept
+ */
+void CarromTableGeometry_Init(CarromTableGeometry* geometry, const CarromGameDef* def, const CarromFrame* frame);
+
+/**
+ * Distance along a normalized ray until it enters a circle
+ *
+ * @return FLT_MAX if the ray misses or the center is not ahead of the origin,
+ * 0 if the origin is already inside and the ray heads towards the center
+ */
+float CarromRayCircle(b2Vec2 origin, b2Vec2 direction, b2Vec2 center, float radius);
+
+/**
+ * Distance along a normalized ray until a disc of the given radius touches the table walls
+ */
+float CarromRayWall(const CarromTableGeometry* geometry, b2Vec2 origin, b2Vec2 direction, float radius);
+
+/**
+ * Classify a shot against the table geometry
+ */
+CarromShotPrefilter CarromTableGeometry_Prefilter(const CarromTableGeometry* geometry, const CarromShot* shot);
@@ -0,0 +1,200 @@
+#include "core.h"
+#include "geometry.h"
+#include "overlap.h"
+
+#include <macaron/macaron.h>
+
+static uint32_t CarromRng_Next(CarromRng* rng)
+{
+	const uint64_t old = rng->state;
+	rng->state = old * 6364136223846793005ull + 1442695040888963407ull;
+
+	const uint32_t xorShifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+	const uint32_t rotation = (uint32_t)(old >> 59u);
+	return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31u));
+}
+
+CarromRng CarromRng_New(const uint64_t seed)
+{
+	CarromRng rng = {0};
+	CarromRng_Next(&rng);
+	rng.state += seed;
+	CarromRng_Next(&rng);
+	return rng;
+}
+
+/**
+ * Uniform float in [min, max)
+ */
+static float CarromRng_Range(CarromRng* rng, const float min, const float max)
+{
+	// top 24 bits fill the float mantissa exactly
+	const float unit = (float)(CarromRng_Next(rng) >> 8) * (1.0f / 16777216.0f);
+	return min + (max - min) * unit;
+}
+
+/**
+ * Uniform point in the disc of a radius around a center, by rejection to avoid trigonometry
+ */
+static b2Vec2 CarromRng_InDisc(CarromRng* rng, const b2Vec2 center, const float radius)
+{
+	float x;
+	float y;
+	do
+	{
+		x = CarromRng_Range(rng, -1.0f, 1.0f);
+		y = CarromRng_Range(rng, -1.0f, 1.0f);
+	} while (x * x + y * y > 1.0f);
+
+	return (b2Vec2){center.x + radius * x, center.y + radius * y};
+}
+
+// Table limits shared by every dart of a layout
+typedef struct CarromLayoutBounds
+{
+	float limitX;
+	float limitY;
+	b2Vec2 pockets[MAX_POCKET_CAPACITY];
+	float pocketDistance;
+} CarromLayoutBounds;
+
+static bool CarromLayoutBounds_Contains(const CarromLayoutBounds* bounds, const b2Vec2 point)
+{
+	if (b2AbsFloat(point.x) > bounds->limitX || b2AbsFloat(point.y) > bounds->limitY)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+	{
+		if (b2DistanceSquared(point, bounds->pockets[i]) < bounds->pocketDistance * bounds->pocketDistance)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int CarromRandomLayout(const CarromRandomLayoutDef* def, CarromRng* rng, int numBlack, int numWhite, const bool hasRed,
+                       CarromObjectPositionDef* out)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(rng != NULL);
+	MACARON_ASSERT(out != NULL);
+	if (def == NULL || rng == NULL || out == NULL)
+	{
+		return 0;
+	}
+
+	numBlack = numBlack < 0 ? 0 : numBlack;
+	numBlack = numBlack > IDX_PUCK_BLACK_END - IDX_PUCK_BLACK_START ? IDX_PUCK_BLACK_END - IDX_PUCK_BLACK_START : numBlack;
+	numWhite = numWhite < 0 ? 0 : numWhite;
+	numWhite = numWhite > IDX_PUCK_WHITE_END - IDX_PUCK_WHITE_START ? IDX_PUCK_WHITE_END - IDX_PUCK_WHITE_START : numWhite;
+
+	const CarromGameDef* gameDef = &def->gameDef;
+	const float r = gameDef->puckPhysicsDef.radius;
+	const float distance = 2 * r + def->clearance;
+
+	CarromLayoutBounds bounds = {0};
+	bounds.limitX = gameDef->worldDef.width / 2 - r - def->clearance;
+	bounds.limitY = gameDef->worldDef.height / 2 - r - def->clearance;
+	CarromPocketPositions(&gameDef->worldDef, &gameDef->pocketDef, bounds.pockets);
+	// a puck touching the pocket sensor is already pocketed
+	bounds.pocketDistance = gameDef->pocketDef.radius + r + def->clearance;
+
+	int indexes[PUCK_IDX_COUNT];
+	int count = 0;
+	if (hasRed)
+	{
+		indexes[count++] = IDX_PUCK_RED;
+	}
+	for (int i = 0; i < numBlack; i++)
+	{
+		indexes[count++] = IDX_PUCK_BLACK_START + i;
+	}
+	for (int i = 0; i < numWhite; i++)
+	{
+		indexes[count++] = IDX_PUCK_WHITE_START + i;
+	}
+
+	b2Vec2 clusters[PUCK_IDX_COUNT];
+	const int numClusters = def->numClusters < PUCK_IDX_COUNT ? def->numClusters : PUCK_IDX_COUNT;
+	for (int i = 0; i < numClusters; i++)
+	{
+		// the table center is the fallback when pockets cover every try, it is never a pocket
+		clusters[i] = b2Vec2_zero;
+		for (int attempt = 0; attempt < def->maxAttempts; attempt++)
+		{
+			const b2Vec2 center = {CarromRng_Range(rng, -bounds.limitX, bounds.limitX),
+			                       CarromRng_Range(rng, -bounds.limitY, bounds.limitY)};
+			if (CarromLayoutBounds_Contains(&bounds, center))
+			{
+				clusters[i] = center;
+				break;
+			}
+		}
+	}
+
+	// with at most 19 accepted pucks the SIMD overlap kernel beats a background grid
+	CarromPuckSet set;
+	CarromPuckSet_Clear(&set);
+
+	bool needsRelax = false;
+	for (int i = 0; i < count; i++)
+	{
+		b2Vec2 dart = b2Vec2_zero;
+		bool accepted = false;
+
+		// cluster darts first, then anywhere on the table, where a free spot is all but certain
+		for (int attempt = 0; attempt < 2 * def->maxAttempts && !accepted; attempt++)
+		{
+			const bool clustered = attempt < def->maxAttempts && numClusters > 0 &&
+			                       CarromRng_Range(rng, 0.0f, 1.0f) < def->clustering;
+			if (clustered)
+			{
+				const int cluster = (int)(CarromRng_Next(rng) % (uint32_t)numClusters);
+				dart = CarromRng_InDisc(rng, clusters[cluster], def->clusterRadius);
+			}
+			else
+			{
+				dart = (b2Vec2){CarromRng_Range(rng, -bounds.limitX, bounds.limitX),
+				                CarromRng_Range(rng, -bounds.limitY, bounds.limitY)};
+			}
+
+			accepted = CarromLayoutBounds_Contains(&bounds, dart) && !CarromPuckSet_Overlaps(&set, dart, distance);
+		}
+
+		// an overcrowded table keeps the last dart and relaxes everything at the end
+		needsRelax = needsRelax || !accepted;
+
+		CarromPuckSet_Add(&set, indexes[i], dart);
+	}
+
+	if (needsRelax)
+	{
+		CarromRelaxDef relaxDef = {0};
+		relaxDef.distance = distance;
+		relaxDef.limitX = bounds.limitX;
+		relaxDef.limitY = bounds.limitY;
+		relaxDef.pockets = bounds.pockets;
+		relaxDef.numPockets = MAX_POCKET_CAPACITY;
+		relaxDef.pocketDistance = bounds.pocketDistance;
+		relaxDef.maxIterations = 64;
+		relaxDef.tolerance = def->clearance / 10;
+		const float violation = CarromRelaxDiscs(set.px, set.py, count, count, &relaxDef);
+
+		// still overlapping, too many pucks for the table
+		if (violation > relaxDef.tolerance)
+		{
+			return 0;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		out[i] = (CarromObjectPositionDef){indexes[i], {set.px[i], set.py[i]}};
+	}
+
+	return count;
+}
@@ -0,0 +1,504 @@
+#include "core.h"
+#include "overlap.h"
+
+#include <float.h>
+
+// far enough that a padding slot never wins, small enough that its squared distance stays finite
+#define CARROM_PUCK_SET_FAR 1.0e6f
+
+void CarromPuckSet_Clear(CarromPuckSet* set)
+{
+	for (int i = 0; i < CARROM_PUCK_SET_CAPACITY; i++)
+	{
+		set->px[i] = CARROM_PUCK_SET_FAR;
+		set->py[i] = CARROM_PUCK_SET_FAR;
+		set->indexes[i] = -1;
+	}
+	set->count = 0;
+}
+
+void CarromPuckSet_Add(CarromPuckSet* set, const int index, const b2Vec2 position)
+{
+	MACARON_ASSERT(set->count < CARROM_PUCK_SET_CAPACITY);
+	if (set->count >= CARROM_PUCK_SET_CAPACITY)
+	{
+		return;
+	}
+
+	set->px[set->count] = position.x;
+	set->py[set->count] = position.y;
+	set->indexes[set->count] = (int8_t)index;
+	set->count++;
+}
+
+static CarromFloatW CarromPuckSet_DistanceSquared(const CarromPuckSet* set, const int slot, const CarromFloatW x,
+                                                  const CarromFloatW y)
+{
+	const CarromFloatW dx = CarromSubW(CarromLoadW(set->px + slot), x);
+	const CarromFloatW dy = CarromSubW(CarromLoadW(set->py + slot), y);
+	return CarromMulAddW(CarromMulW(dx, dx), dy, dy);
+}
+
+int CarromPuckSet_Nearest(const CarromPuckSet* set, const b2Vec2 point, float* distanceSquared)
+{
+	static const float laneIndexes[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+	if (set->count == 0)
+	{
+		return -1;
+	}
+
+	const CarromFloatW x = CarromSplatW(point.x);
+	const CarromFloatW y = CarromSplatW(point.y);
+
+	// per lane minimum, the first slot wins ties like a sequential scan
+	CarromFloatW best = CarromSplatW(FLT_MAX);
+	CarromFloatW bestSlot = CarromZeroW();
+	CarromFloatW slots = CarromLoadW(laneIndexes);
+	const CarromFloatW slotStep = CarromSplatW((float)CARROM_LANES);
+
+	for (int slot = 0; slot < set->count; slot += CARROM_LANES)
+	{
+		const CarromFloatW d = CarromPuckSet_DistanceSquared(set, slot, x, y);
+		const CarromFloatW closer = CarromLessW(d, best);
+		best = CarromBlendW(best, d, closer);
+		bestSlot = CarromBlendW(bestSlot, slots, closer);
+		slots = CarromAddW(slots, slotStep);
+	}
+
+	float bests[CARROM_LANES];
+	float bestSlots[CARROM_LANES];
+	CarromStoreW(bests, best);
+	CarromStoreW(bestSlots, bestSlot);
+
+	int nearest = (int)bestSlots[0];
+	float nearestDistance = bests[0];
+	for (int lane = 1; lane < CARROM_LANES; lane++)
+	{
+		const int slot = (int)bestSlots[lane];
+		if (bests[lane] < nearestDistance || (bests[lane] == nearestDistance && slot < nearest))
+		{
+			nearest = slot;
+			nearestDistance = bests[lane];
+		}
+	}
+
+	if (distanceSquared != NULL)
+	{
+		*distanceSquared = nearestDistance;
+	}
+
+	return nearest;
+}
+
+bool CarromPuckSet_Overlaps(const CarromPuckSet* set, const b2Vec2 point, const float distance)
+{
+	const CarromFloatW x = CarromSplatW(point.x);
+	const CarromFloatW y = CarromSplatW(point.y);
+	const CarromFloatW limit = CarromSplatW(distance * distance);
+
+	for (int slot = 0; slot < set->count; slot += CARROM_LANES)
+	{
+		const CarromFloatW d = CarromPuckSet_DistanceSquared(set, slot, x, y);
+		if (CarromMaskToBitsW(CarromLessW(d, limit)) != 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int CarromPuckSet_OverlapBatch(const CarromPuckSet* set, const b2Vec2* points, const int count, const float distance,
+                               bool* overlaps)
+{
+	const CarromFloatW limit = CarromSplatW(distance * distance);
+
+	int numOverlaps = 0;
+	for (int first = 0; first < count; first += CARROM_LANES)
+	{
+		const int numPoints = count - first < CARROM_LANES ? count - first : CARROM_LANES;
+
+		// transpose the points, missing lanes sit far away like the padding slots
+		float xs[CARROM_LANES];
+		float ys[CARROM_LANES];
+		for (int lane = 0; lane < CARROM_LANES; lane++)
+		{
+			xs[lane] = lane < numPoints ? points[first + lane].x : -CARROM_PUCK_SET_FAR;
+			ys[lane] = lane < numPoints ? points[first + lane].y : -CARROM_PUCK_SET_FAR;
+		}
+
+		const CarromFloatW x = CarromLoadW(xs);
+		const CarromFloatW y = CarromLoadW(ys);
+
+		CarromFloatW hit = CarromZeroW();
+		for (int slot = 0; slot < set->count; slot++)
+		{
+			const CarromFloatW dx = CarromSubW(x, CarromSplatW(set->px[slot]));
+			const CarromFloatW dy = CarromSubW(y, CarromSplatW(set->py[slot]));
+			hit = CarromOrW(hit, CarromLessW(CarromMulAddW(CarromMulW(dx, dx), dy, dy), limit));
+		}
+
+		const uint32_t bits = CarromMaskToBitsW(hit);
+		for (int lane = 0; lane < numPoints; lane++)
+		{
+			overlaps[first + lane] = (bits & (1u << lane)) != 0;
+			numOverlaps += overlaps[first + lane] ? 1 : 0;
+		}
+	}
+
+	return numOverlaps;
+}
+
+// relative slack on the squared distance, points found on a circle count as free
+#define CARROM_FREE_TOLERANCE 1.0e-4f
+
+static uint32_t CarromGrid_Bucket(const int32_t cellX, const int32_t cellY)
+{
+	return ((uint32_t)cellX * 92837111u ^ (uint32_t)cellY * 689287499u) & (CARROM_GRID_BUCKETS - 1);
+}
+
+void CarromGrid_Build(CarromGrid* grid, const float* px, const float* py, const int count, const float cellSize)
+{
+	MACARON_ASSERT(count <= CARROM_GRID_CAPACITY);
+	MACARON_ASSERT(cellSize > 0.0f);
+
+	grid->px = px;
+	grid->py = py;
+	grid->count = count < CARROM_GRID_CAPACITY ? count : CARROM_GRID_CAPACITY;
+	grid->invCellSize = 1.0f / cellSize;
+
+	for (int i = 0; i < CARROM_GRID_BUCKETS; i++)
+	{
+		grid->heads[i] = -1;
+	}
+
+	for (int i = 0; i < grid->count; i++)
+	{
+		grid->cellX[i] = (int32_t)floorf(px[i] * grid->invCellSize);
+		grid->cellY[i] = (int32_t)floorf(py[i] * grid->invCellSize);
+
+		const uint32_t bucket = CarromGrid_Bucket(grid->cellX[i], grid->cellY[i]);
+		grid->next[i] = grid->heads[bucket];
+		grid->heads[bucket] = (int8_t)i;
+	}
+}
+
+int CarromGrid_Query(const CarromGrid* grid, const b2Vec2 point, const float radius, int* indexes, const int capacity)
+{
+	const int32_t minX = (int32_t)floorf((point.x - radius) * grid->invCellSize);
+	const int32_t maxX = (int32_t)floorf((point.x + radius) * grid->invCellSize);
+	const int32_t minY = (int32_t)floorf((point.y - radius) * grid->invCellSize);
+	const int32_t maxY = (int32_t)floorf((point.y + radius) * grid->invCellSize);
+
+	int count = 0;
+
+	// a wide query visits more cells than there are points, scan the points instead
+	if ((int64_t)(maxX - minX + 1) * (maxY - minY + 1) > grid->count)
+	{
+		for (int i = 0; i < grid->count && count < capacity; i++)
+		{
+			if (grid->cellX[i] >= minX && grid->cellX[i] <= maxX && grid->cellY[i] >= minY && grid->cellY[i] <= maxY)
+			{
+				indexes[count++] = i;
+			}
+		}
+		return count;
+	}
+
+	for (int32_t y = minY; y <= maxY; y++)
+	{
+		for (int32_t x = minX; x <= maxX; x++)
+		{
+			// buckets are shared by distant cells, the stored cell tells them apart
+			for (int i = grid->heads[CarromGrid_Bucket(x, y)]; i >= 0 && count < capacity; i = grid->next[i])
+			{
+				if (grid->cellX[i] == x && grid->cellY[i] == y)
+				{
+					indexes[count++] = i;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+static bool CarromGrid_IsFree(const CarromGrid* grid, const b2Vec2 point, const float distance)
+{
+	int neighbors[CARROM_GRID_CAPACITY];
+	const int count = CarromGrid_Query(grid, point, distance, neighbors, CARROM_GRID_CAPACITY);
+
+	const float limit = distance * distance * (1.0f - CARROM_FREE_TOLERANCE);
+	for (int i = 0; i < count; i++)
+	{
+		const float dx = grid->px[neighbors[i]] - point.x;
+		const float dy = grid->py[neighbors[i]] - point.y;
+		if (dx * dx + dy * dy < limit)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Best free candidate so far
+typedef struct CarromFreePoint
+{
+	const CarromGrid* grid;
+	b2Vec2 target;
+	float distance;
+	float limitX;
+	float limitY;
+	bool found;
+	b2Vec2 point;
+	float distanceSquared;
+} CarromFreePoint;
+
+static void CarromFreePoint_Consider(CarromFreePoint* best, const b2Vec2 candidate)
+{
+	const float slack = CARROM_FREE_TOLERANCE * best->distance;
+	if (b2AbsFloat(candidate.x) > best->limitX + slack || b2AbsFloat(candidate.y) > best->limitY + slack)
+	{
+		return;
+	}
+
+	const float distanceSquared = b2DistanceSquared(candidate, best->target);
+	if (best->found && distanceSquared >= best->distanceSquared)
+	{
+		return;
+	}
+
+	if (!CarromGrid_IsFree(best->grid, candidate, best->distance))
+	{
+		return;
+	}
+
+	best->found = true;
+	best->point = candidate;
+	best->distanceSquared = distanceSquared;
+}
+
+/**
+ * Both crossings of a circle with the line where coordinate axis equals value
+ */
+static void CarromFreePoint_ConsiderLine(CarromFreePoint* best, const b2Vec2 center, const int axis, const float value)
+{
+	const float offset = value - (axis == 0 ? center.x : center.y);
+	const float h = best->distance * best->distance - offset * offset;
+	if (h < 0.0f)
+	{
+		return;
+	}
+
+	const float s = sqrtf(h);
+	if (axis == 0)
+	{
+		CarromFreePoint_Consider(best, (b2Vec2){value, center.y - s});
+		CarromFreePoint_Consider(best, (b2Vec2){value, center.y + s});
+	}
+	else
+	{
+		CarromFreePoint_Consider(best, (b2Vec2){center.x - s, value});
+		CarromFreePoint_Consider(best, (b2Vec2){center.x + s, value});
+	}
+}
+
+b2Vec2 CarromPuckSet_NearestFree(const CarromPuckSet* set, const b2Vec2 target, const float distance, const float limitX,
+                                 const float limitY)
+{
+	const b2Vec2 clamped = {b2ClampFloat(target.x, -limitX, limitX), b2ClampFloat(target.y, -limitY, limitY)};
+
+	CarromGrid grid;
+	CarromGrid_Build(&grid, set->px, set->py, set->count, distance);
+
+	if (CarromGrid_IsFree(&grid, clamped, distance))
+	{
+		return clamped;
+	}
+
+	CarromFreePoint best = {0};
+	best.grid = &grid;
+	best.target = target;
+	best.distance = distance;
+	best.limitX = limitX;
+	best.limitY = limitY;
+
+	// limit edges and corners
+	CarromFreePoint_Consider(&best, (b2Vec2){-limitX, clamped.y});
+	CarromFreePoint_Consider(&best, (b2Vec2){limitX, clamped.y});
+	CarromFreePoint_Consider(&best, (b2Vec2){clamped.x, -limitY});
+	CarromFreePoint_Consider(&best, (b2Vec2){clamped.x, limitY});
+	CarromFreePoint_Consider(&best, (b2Vec2){-limitX, -limitY});
+	CarromFreePoint_Consider(&best, (b2Vec2){limitX, -limitY});
+	CarromFreePoint_Consider(&best, (b2Vec2){-limitX, limitY});
+	CarromFreePoint_Consider(&best, (b2Vec2){limitX, limitY});
+
+	for (int i = 0; i < set->count; i++)
+	{
+		const b2Vec2 center = {set->px[i], set->py[i]};
+
+		// straight out of a single circle, a target on the center leaves along +x
+		const b2Vec2 away = b2Sub(target, center);
+		const float length = b2Length(away);
+		const b2Vec2 direction = length > FLT_EPSILON ? b2MulSV(1.0f / length, away) : (b2Vec2){1.0f, 0.0f};
+		CarromFreePoint_Consider(&best, b2MulAdd(center, distance, direction));
+
+		CarromFreePoint_ConsiderLine(&best, center, 0, -limitX);
+		CarromFreePoint_ConsiderLine(&best, center, 0, limitX);
+		CarromFreePoint_ConsiderLine(&best, center, 1, -limitY);
+		CarromFreePoint_ConsiderLine(&best, center, 1, limitY);
+
+		// crossings with the circles around close centers
+		int neighbors[CARROM_GRID_CAPACITY];
+		const int numNeighbors = CarromGrid_Query(&grid, center, 2 * distance, neighbors, CARROM_GRID_CAPACITY);
+		for (int n = 0; n < numNeighbors; n++)
+		{
+			const int j = neighbors[n];
+			if (j <= i)
+			{
+				continue;
+			}
+
+			const b2Vec2 delta = {set->px[j] - center.x, set->py[j] - center.y};
+			const float d = b2Length(delta);
+			if (d <= FLT_EPSILON || d >= 2 * distance)
+			{
+				continue;
+			}
+
+			const b2Vec2 mid = b2MulAdd(center, 0.5f, delta);
+			const float h = sqrtf(distance * distance - 0.25f * d * d);
+			const b2Vec2 normal = {-delta.y / d, delta.x / d};
+			CarromFreePoint_Consider(&best, b2MulAdd(mid, h, normal));
+			CarromFreePoint_Consider(&best, b2MulSub(mid, h, normal));
+		}
+	}
+
+	if (!best.found)
+	{
+		return clamped;
+	}
+
+	return (b2Vec2){b2ClampFloat(best.point.x, -limitX, limitX), b2ClampFloat(best.point.y, -limitY, limitY)};
+}
+
+/**
+ * Push a disc out of a circle, coincident centers get a direction spread by the golden angle
+ */
+static b2Vec2 CarromRelax_Separation(const float dx, const float dy, const float distance, const int seed)
+{
+	const float d2 = dx * dx + dy * dy;
+	if (d2 < FLT_EPSILON * distance * distance)
+	{
+		const float angle = (float)seed * 2.39996323f;
+		return (b2Vec2){distance * cosf(angle), distance * sinf(angle)};
+	}
+
+	const float d = sqrtf(d2);
+	const float push = (distance - d) / d;
+	return (b2Vec2){dx * push, dy * push};
+}
+
+float CarromRelaxDiscs(float* px, float* py, const int numMoving, const int count, const CarromRelaxDef* def)
+{
+	MACARON_ASSERT(numMoving <= count);
+	MACARON_ASSERT(count <= CARROM_GRID_CAPACITY);
+
+	const float distance = def->distance;
+	const float distance2 = distance * distance;
+
+	float maxViolation = 0.0f;
+	for (int iteration = 0; iteration < def->maxIterations; iteration++)
+	{
+		maxViolation = 0.0f;
+
+		// cells go stale while discs move, a disc missed here is caught by the next pass
+		CarromGrid grid;
+		CarromGrid_Build(&grid, px, py, count, distance);
+
+		for (int i = 0; i < numMoving; i++)
+		{
+			int neighbors[CARROM_GRID_CAPACITY];
+			const int numNeighbors = CarromGrid_Query(&grid, (b2Vec2){px[i], py[i]}, distance, neighbors,
+			                                          CARROM_GRID_CAPACITY);
+			for (int k = 0; k < numNeighbors; k++)
+			{
+				// moving pairs are visited once, from the lower index
+				const int j = neighbors[k];
+				if (j == i || (j < numMoving && j < i))
+				{
+					continue;
+				}
+
+				const float dx = px[i] - px[j];
+				const float dy = py[i] - py[j];
+				if (dx * dx + dy * dy >= distance2)
+				{
+					continue;
+				}
+
+				const b2Vec2 push = CarromRelax_Separation(dx, dy, distance, i * NUM_OF_OBJECTS + j);
+				maxViolation = b2MaxFloat(maxViolation, b2Length(push));
+				if (j < numMoving)
+				{
+					px[i] += push.x / 2;
+					py[i] += push.y / 2;
+					px[j] -= push.x / 2;
+					py[j] -= push.y / 2;
+				}
+				else
+				{
+					px[i] += push.x;
+					py[i] += push.y;
+				}
+			}
+		}
+
+		for (int i = 0; i < numMoving; i++)
+		{
+			float x = b2ClampFloat(px[i], -def->limitX, def->limitX);
+			float y = b2ClampFloat(py[i], -def->limitY, def->limitY);
+
+			for (int p = 0; p < def->numPockets; p++)
+			{
+				const b2Vec2 pocket = def->pockets[p];
+				const float reach = def->pocketDistance;
+				if ((x - pocket.x) * (x - pocket.x) + (y - pocket.y) * (y - pocket.y) >= reach * reach)
+				{
+					continue;
+				}
+
+				const b2Vec2 push = CarromRelax_Separation(x - pocket.x, y - pocket.y, reach, i);
+				x += push.x;
+				y += push.y;
+
+				// pushed through a wall, slide along it to the pocket edge on the table side instead
+				if (b2AbsFloat(x) > def->limitX)
+				{
+					x = b2ClampFloat(x, -def->limitX, def->limitX);
+					const float h = sqrtf(b2MaxFloat(reach * reach - (x - pocket.x) * (x - pocket.x), 0.0f));
+					y = pocket.y - copysignf(h, pocket.y);
+				}
+				else if (b2AbsFloat(y) > def->limitY)
+				{
+					y = b2ClampFloat(y, -def->limitY, def->limitY);
+					const float h = sqrtf(b2MaxFloat(reach * reach - (y - pocket.y) * (y - pocket.y), 0.0f));
+					x = pocket.x - copysignf(h, pocket.x);
+				}
+			}
+
+			maxViolation = b2MaxFloat(maxViolation, b2Length((b2Vec2){x - px[i], y - py[i]}));
+			px[i] = x;
+			py[i] = y;
+		}
+
+		if (maxViolation <= def->tolerance)
+		{
+			break;
+		}
+	}
+
+	return maxViolation;
+}
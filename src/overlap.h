@@ -0,0 +1,129 @@
+#pragma once
+
+#include "simd.h"
+
+#include <macaron/types.h>
+
+// puck slots rounded up to whole SIMD vectors
+#define CARROM_PUCK_SET_CAPACITY ((PUCK_IDX_COUNT + CARROM_LANES - 1) / CARROM_LANES * CARROM_LANES)
+
+// Puck centers in SoA form for the overlap kernels, unused slots sit far outside the table
+typedef struct CarromPuckSet
+{
+	// center x of each slot
+	float px[CARROM_PUCK_SET_CAPACITY];
+	// center y of each slot
+	float py[CARROM_PUCK_SET_CAPACITY];
+	// object index of each slot
+	int8_t indexes[CARROM_PUCK_SET_CAPACITY];
+	// number of used slots
+	int count;
+
+} CarromPuckSet;
+
+void CarromPuckSet_Clear(CarromPuckSet* set);
+
+void CarromPuckSet_Add(CarromPuckSet* set, int index, b2Vec2 position);
+
+/**
+ * Closest center to a point
+ *
+ * @return slot of the closest center, -1 if the set is empty
+ */
+int CarromPuckSet_Nearest(const CarromPuckSet* set, b2Vec2 point, float* distanceSquared);
+
+/**
+ * true if any center is strictly closer than distance to the point
+ */
+bool CarromPuckSet_Overlaps(const CarromPuckSet* set, b2Vec2 point, float distance);
+
+/**
+ * Overlap test of many points at once, one point per lane
+ *
+ * @param overlaps output flags, one per point
+ *
+ * @return number of overlapping points
+ */
+int CarromPuckSet_OverlapBatch(const CarromPuckSet* set, const b2Vec2* points, int count, float distance,
+                               bool* overlaps);
+
+// most points in a grid, every object fits
+#define CARROM_GRID_CAPACITY 32
+
+// buckets of the grid hash, power of two
+#define CARROM_GRID_BUCKETS 64
+
+// Spatial hash over a small point set, points are not copied and must outlive the grid
+typedef struct CarromGrid
+{
+	// point coordinates
+	const float* px;
+	const float* py;
+	// number of points
+	int count;
+	// inverse of the cell size
+	float invCellSize;
+	// cell of each point
+	int32_t cellX[CARROM_GRID_CAPACITY];
+	int32_t cellY[CARROM_GRID_CAPACITY];
+	// first point of each bucket, -1 if empty
+	int8_t heads[CARROM_GRID_BUCKETS];
+	// next point in the same bucket, -1 at the end
+	int8_t next[CARROM_GRID_CAPACITY];
+
+} CarromGrid;
+
+void CarromGrid_Build(CarromGrid* grid, const float* px, const float* py, int count, float cellSize);
+
+/**
+ * Points whose cell touches the square of half size radius around a point, a superset of the points closer than radius
+ *
+ * @return number of indexes written, at most capacity
+ */
+int CarromGrid_Query(const CarromGrid* grid, b2Vec2 point, float radius, int* indexes, int capacity);
+
+/**
+ * Closest point to target which keeps at least distance to every center of the set and stays inside the limits
+ *
+ * candidates are the projections on single circles, circle-circle and circle-limit intersections and the limit corners,
+ * which is where the closest point lies whenever the target itself is taken, the cost is bounded by the set size
+ *
+ * @param limitX largest absolute x
+ * @param limitY largest absolute y
+ *
+ * @return the clamped target if there is no free point at all
+ */
+b2Vec2 CarromPuckSet_NearestFree(const CarromPuckSet* set, b2Vec2 target, float distance, float limitX, float limitY);
+
+// Relaxation of CarromRelaxDiscs
+typedef struct CarromRelaxDef
+{
+	// smallest distance between two centers
+	float distance;
+	// largest absolute center coordinates
+	float limitX;
+	float limitY;
+	// pocket centers, centers closer than pocketDistance to one are pushed out
+	const b2Vec2* pockets;
+	int numPockets;
+	float pocketDistance;
+	// relaxation passes at most
+	int maxIterations;
+	// largest violation accepted, stops the passes early
+	float tolerance;
+
+} CarromRelaxDef;
+
+/**
+ * Project overlapping discs apart, back inside the limits and out of the pockets
+ *
+ * every pass rebuilds a grid over the centers and corrects each violation in place,
+ * the first numMoving discs move and the rest are fixed obstacles
+ *
+ * @param px center x of every disc, updated in place
+ * @param py center y of every disc, updated in place
+ * @param count number of discs, at most CARROM_GRID_CAPACITY
+ *
+ * @return largest violation found by the last pass
+ */
+float CarromRelaxDiscs(float* px, float* py, int numMoving, int count, const CarromRelaxDef* def);
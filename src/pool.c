@@ -0,0 +1,124 @@
+#include "core.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+
+CarromGameStatePool CarromGameStatePool_Create(const CarromGameDef* def, const int capacity)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(capacity > 0);
+
+	CarromGameStatePool pool = {0};
+	if (def == NULL || capacity <= 0)
+	{
+		return pool;
+	}
+
+	pool.states = malloc(sizeof(CarromGameState) * (size_t)capacity);
+	pool.freeList = malloc(sizeof(int32_t) * (size_t)capacity);
+	if (pool.states == NULL || pool.freeList == NULL)
+	{
+		free(pool.states);
+		free(pool.freeList);
+		return (CarromGameStatePool){0};
+	}
+
+	pool.def = *def;
+	pool.capacity = capacity;
+	pool.freeCount = capacity;
+
+	for (int i = 0; i < capacity; i++)
+	{
+		pool.states[i] = CarromGameState_New(def);
+		// hand out the lowest index first
+		pool.freeList[i] = capacity - 1 - i;
+	}
+
+	return pool;
+}
+
+CarromGameState* CarromGameStatePool_Acquire(CarromGameStatePool* pool)
+{
+	MACARON_ASSERT(pool != NULL);
+	if (pool == NULL || pool->freeCount == 0)
+	{
+		return NULL;
+	}
+
+	pool->freeCount--;
+	return &pool->states[pool->freeList[pool->freeCount]];
+}
+
+CarromGameState* CarromGameStatePool_AcquireReset(CarromGameStatePool* pool, const CarromFrame* frame)
+{
+	CarromGameState* state = CarromGameStatePool_Acquire(pool);
+	if (state != NULL)
+	{
+		CarromGameState_Reset(state, frame);
+	}
+
+	return state;
+}
+
+int CarromGameStatePool_Fork(CarromGameStatePool* pool, const CarromGameState* state, const int count,
+                             CarromGameState** outStates)
+{
+	MACARON_ASSERT(pool != NULL);
+	MACARON_ASSERT(outStates != NULL);
+	if (pool == NULL || outStates == NULL)
+	{
+		return 0;
+	}
+
+	int acquired = 0;
+	while (acquired < count)
+	{
+		CarromGameState* forkState = CarromGameStatePool_Acquire(pool);
+		if (forkState == NULL)
+		{
+			break;
+		}
+		outStates[acquired++] = forkState;
+	}
+
+	return CarromGameState_Fork(state, acquired, outStates);
+}
+
+void CarromGameStatePool_Release(CarromGameStatePool* pool, CarromGameState* state)
+{
+	MACARON_ASSERT(pool != NULL);
+	MACARON_ASSERT(state != NULL);
+	if (pool == NULL || state == NULL)
+	{
+		return;
+	}
+
+	const ptrdiff_t index = state - pool->states;
+	MACARON_ASSERT(index >= 0 && index < pool->capacity);
+	MACARON_ASSERT(pool->freeCount < pool->capacity);
+	if (index < 0 || index >= pool->capacity || pool->freeCount >= pool->capacity)
+	{
+		return;
+	}
+
+	pool->freeList[pool->freeCount++] = (int32_t)index;
+}
+
+void CarromGameStatePool_Destroy(CarromGameStatePool* pool)
+{
+	MACARON_ASSERT(pool != NULL);
+	if (pool == NULL)
+	{
+		return;
+	}
+
+	for (int i = 0; i < pool->capacity; i++)
+	{
+		CarromGameState_Destroy(&pool->states[i]);
+	}
+
+	free(pool->states);
+	free(pool->freeList);
+	*pool = (CarromGameStatePool){0};
+}
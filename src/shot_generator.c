@@ -0,0 +1,348 @@
+#include "core.h"
+#include "geometry.h"
+#include "overlap.h"
+
+#include <macaron/macaron.h>
+
+#define NUM_OF_CUSHIONS 4
+
+// baseline samples tested against the pucks at once
+#define BASELINE_CHUNK 64
+
+typedef struct CarromShotGenerator
+{
+	const CarromShotGeneratorDef* def;
+	CarromTableGeometry geometry;
+	CarromShotCandidate* candidates;
+	int capacity;
+	int count;
+} CarromShotGenerator;
+
+// mirror a point across a cushion, the cushion line is pulled in by the radius of the bouncing disc
+static b2Vec2 CarromShotGenerator_Mirror(const CarromTableGeometry* geometry, const int cushion, const float radius,
+                                         const b2Vec2 p)
+{
+	const float limitX = geometry->halfWidth - radius;
+	const float limitY = geometry->halfHeight - radius;
+
+	switch (cushion)
+	{
+		case 0:
+			return (b2Vec2){-2 * limitX - p.x, p.y};
+		case 1:
+			return (b2Vec2){2 * limitX - p.x, p.y};
+		case 2:
+			return (b2Vec2){p.x, -2 * limitY - p.y};
+		default:
+			return (b2Vec2){p.x, 2 * limitY - p.y};
+	}
+}
+
+// reflect a direction off a cushion
+static b2Vec2 CarromShotGenerator_Reflect(const int cushion, const b2Vec2 direction)
+{
+	if (cushion < 2)
+	{
+		return (b2Vec2){-direction.x, direction.y};
+	}
+
+	return (b2Vec2){direction.x, -direction.y};
+}
+
+// true if a disc moving from a to b does not touch any puck other than the excluded one
+static bool CarromShotGenerator_PathClear(const CarromTableGeometry* geometry, const b2Vec2 a, const b2Vec2 b,
+                                          const float radius, const int excluded)
+{
+	const b2Vec2 delta = b2Sub(b, a);
+	const float length = b2Length(delta);
+	if (length == 0.0f)
+	{
+		return true;
+	}
+
+	const b2Vec2 direction = b2MulSV(1.0f / length, delta);
+	for (int i = 0; i < geometry->numPucks; i++)
+	{
+		if (i == excluded)
+		{
+			continue;
+		}
+
+		if (CarromRayCircle(a, direction, geometry->pucks[i], geometry->puckRadius + radius) < length)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// true if a disc moving from a to b does not reach a pocket sensor on the way
+static bool CarromShotGenerator_PocketClear(const CarromTableGeometry* geometry, const b2Vec2 a, const b2Vec2 b,
+                                            const float radius)
+{
+	const b2Vec2 delta = b2Sub(b, a);
+	const float length = b2Length(delta);
+	if (length == 0.0f)
+	{
+		return true;
+	}
+
+	const b2Vec2 direction = b2MulSV(1.0f / length, delta);
+	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+	{
+		if (CarromRayCircle(a, direction, geometry->pockets[i], geometry->pocketRadius + radius) < length)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// point where a disc aimed at a mirror image touches the cushion, false if it drops into a pocket or hits
+// another cushion first
+static bool CarromShotGenerator_BankPoint(const CarromTableGeometry* geometry, const int cushion, const b2Vec2 a,
+                                          const b2Vec2 mirrored, const float radius, b2Vec2* bankPoint)
+{
+	const b2Vec2 direction = b2Normalize(b2Sub(mirrored, a));
+	if (b2LengthSquared(direction) == 0.0f)
+	{
+		return false;
+	}
+
+	const float t = CarromRayWall(geometry, a, direction, radius);
+	if (t == FLT_MAX)
+	{
+		return false;
+	}
+
+	*bankPoint = b2MulAdd(a, t, direction);
+
+	const float tolerance = 0.001f * radius;
+	const float limitX = geometry->halfWidth - radius;
+	const float limitY = geometry->halfHeight - radius;
+	const float onCushion = cushion == 0   ? bankPoint->x + limitX
+	                        : cushion == 1 ? limitX - bankPoint->x
+	                        : cushion == 2 ? bankPoint->y + limitY
+	                                       : limitY - bankPoint->y;
+	if (onCushion > tolerance)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
+	{
+		if (CarromRayCircle(a, direction, geometry->pockets[i], geometry->pocketRadius + radius) < t)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void CarromShotGenerator_Push(CarromShotGenerator* generator, const b2Vec2 strikerPos, const b2Vec2 direction,
+                                     const CarromShotKind kind, const int target, const int pocket, const int cushion,
+                                     const float cutCos)
+{
+	if (generator->count >= generator->capacity)
+	{
+		return;
+	}
+
+	CarromShotCandidate* candidate = &generator->candidates[generator->count++];
+	candidate->shot.tablePos = generator->def->tablePos;
+	candidate->shot.strikerPos = strikerPos;
+	candidate->shot.impulse = b2MulSV(generator->def->power, direction);
+	candidate->shot.maxForce = 0.0f;
+	candidate->kind = kind;
+	candidate->targetIndex = generator->geometry.puckIndexes[target];
+	candidate->pocketIndex = (int8_t)pocket;
+	candidate->cushion = (int8_t)cushion;
+	candidate->cutCos = cutCos;
+}
+
+// aim the striker at the ghost ball, directly and off each cushion
+static void CarromShotGenerator_Aim(CarromShotGenerator* generator, const b2Vec2 strikerPos, const int target,
+                                    const int pocket, const b2Vec2 ghost, const b2Vec2 puckDirection,
+                                    const CarromShotKind kind, const int cushion)
+{
+	const CarromTableGeometry* geometry = &generator->geometry;
+	const float strikerR = geometry->strikerRadius;
+
+	const b2Vec2 direction = b2Normalize(b2Sub(ghost, strikerPos));
+	const float cutCos = b2Dot(direction, puckDirection);
+	if (cutCos >= generator->def->minCutCos &&
+	    CarromShotGenerator_PathClear(geometry, strikerPos, ghost, strikerR, target) &&
+	    CarromShotGenerator_PocketClear(geometry, strikerPos, ghost, strikerR))
+	{
+		CarromShotGenerator_Push(generator, strikerPos, direction, kind, target, pocket, cushion, cutCos);
+	}
+
+	// banking both the striker and the puck is left to the physics
+	if (!generator->def->strikerBanks || kind != CarromShotKind_Direct)
+	{
+		return;
+	}
+
+	for (int c = 0; c < NUM_OF_CUSHIONS; c++)
+	{
+		const b2Vec2 mirrored = CarromShotGenerator_Mirror(geometry, c, strikerR, ghost);
+		b2Vec2 bankPoint;
+		if (!CarromShotGenerator_BankPoint(geometry, c, strikerPos, mirrored, strikerR, &bankPoint))
+		{
+			continue;
+		}
+
+		const b2Vec2 bankDirection = b2Normalize(b2Sub(mirrored, strikerPos));
+		const float bankCutCos = b2Dot(CarromShotGenerator_Reflect(c, bankDirection), puckDirection);
+		if (bankCutCos < generator->def->minCutCos)
+		{
+			continue;
+		}
+
+		if (!CarromShotGenerator_PathClear(geometry, strikerPos, bankPoint, strikerR, -1) ||
+		    !CarromShotGenerator_PathClear(geometry, bankPoint, ghost, strikerR, target) ||
+		    !CarromShotGenerator_PocketClear(geometry, bankPoint, ghost, strikerR))
+		{
+			continue;
+		}
+
+		CarromShotGenerator_Push(generator, strikerPos, bankDirection, CarromShotKind_StrikerBank, target, pocket, c,
+		                         bankCutCos);
+	}
+}
+
+int CarromGenerateShots(const CarromGameDef* def, const CarromFrame* frame, const CarromShotGeneratorDef* generatorDef,
+                        CarromShotCandidate* candidates, const int capacity)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(frame != NULL);
+	MACARON_ASSERT(generatorDef != NULL);
+	MACARON_ASSERT(candidates != NULL);
+	if (def == NULL || frame == NULL || generatorDef == NULL || candidates == NULL || capacity <= 0)
+	{
+		return 0;
+	}
+
+	CarromShotGenerator generator = {0};
+	generator.def = generatorDef;
+	generator.candidates = candidates;
+	generator.capacity = capacity;
+	CarromTableGeometry_Init(&generator.geometry, def, frame);
+
+	const CarromTableGeometry* geometry = &generator.geometry;
+	const float puckR = geometry->puckRadius;
+	const float strikerR = geometry->strikerRadius;
+
+	// baseline segment, the limit def decides the legal striker positions
+	b2Vec2 forward;
+	b2Vec2 axis;
+	switch (generatorDef->tablePos)
+	{
+		case CarromTablePosition_Top:
+			forward = (b2Vec2){0.0f, -1.0f};
+			axis = (b2Vec2){1.0f, 0.0f};
+			break;
+		case CarromTablePosition_Left:
+			forward = (b2Vec2){1.0f, 0.0f};
+			axis = (b2Vec2){0.0f, 1.0f};
+			break;
+		case CarromTablePosition_Right:
+			forward = (b2Vec2){-1.0f, 0.0f};
+			axis = (b2Vec2){0.0f, 1.0f};
+			break;
+		default:
+			forward = (b2Vec2){0.0f, 1.0f};
+			axis = (b2Vec2){1.0f, 0.0f};
+			break;
+	}
+
+	const CarromStrikerLimitDef* limitDef = &def->strikerLimitDef;
+	const float halfWidth = CarromStrikerBaselineHalfWidth(&def->worldDef, limitDef, strikerR, generatorDef->tablePos);
+	const b2Vec2 baselineCenter = b2MulSV(-limitDef->centerOffset, forward);
+	const int samples = generatorDef->baselineSamples > 1 ? generatorDef->baselineSamples : 1;
+
+	CarromPuckSet puckSet;
+	CarromPuckSet_Clear(&puckSet);
+	for (int i = 0; i < geometry->numPucks; i++)
+	{
+		CarromPuckSet_Add(&puckSet, geometry->puckIndexes[i], geometry->pucks[i]);
+	}
+
+	b2Vec2 strikerPositions[BASELINE_CHUNK];
+	bool overlaps[BASELINE_CHUNK];
+	for (int s = 0; s < samples && generator.count < capacity; s++)
+	{
+		// the striker can not be placed on top of a puck, samples are tested a chunk at a time
+		const int slot = s % BASELINE_CHUNK;
+		if (slot == 0)
+		{
+			const int chunk = samples - s < BASELINE_CHUNK ? samples - s : BASELINE_CHUNK;
+			for (int k = 0; k < chunk; k++)
+			{
+				const int sample = s + k;
+				const float offset = samples == 1
+					                     ? 0.0f
+					                     : -halfWidth + 2 * halfWidth * (float)sample / (float)(samples - 1);
+				strikerPositions[k] = CarromLimitStrikerPos(limitDef, generatorDef->tablePos,
+				                                            b2MulAdd(baselineCenter, offset, axis));
+			}
+			CarromPuckSet_OverlapBatch(&puckSet, strikerPositions, chunk, puckR + strikerR, overlaps);
+		}
+
+		const b2Vec2 strikerPos = strikerPositions[slot];
+		if (overlaps[slot])
+		{
+			continue;
+		}
+
+		for (int target = 0; target < geometry->numPucks; target++)
+		{
+			const b2Vec2 puckPos = geometry->pucks[target];
+			for (int pocket = 0; pocket < MAX_POCKET_CAPACITY; pocket++)
+			{
+				const b2Vec2 pocketPos = geometry->pockets[pocket];
+
+				// straight into the pocket
+				const b2Vec2 puckDirection = b2Normalize(b2Sub(pocketPos, puckPos));
+				if (CarromShotGenerator_PathClear(geometry, puckPos, pocketPos, puckR, target))
+				{
+					const b2Vec2 ghost = b2MulSub(puckPos, puckR + strikerR, puckDirection);
+					CarromShotGenerator_Aim(&generator, strikerPos, target, pocket, ghost, puckDirection,
+					                        CarromShotKind_Direct, -1);
+				}
+
+				if (!generatorDef->puckBanks)
+				{
+					continue;
+				}
+
+				// off one cushion into the pocket
+				for (int c = 0; c < NUM_OF_CUSHIONS; c++)
+				{
+					const b2Vec2 mirrored = CarromShotGenerator_Mirror(geometry, c, puckR, pocketPos);
+					b2Vec2 bankPoint;
+					if (!CarromShotGenerator_BankPoint(geometry, c, puckPos, mirrored, puckR, &bankPoint))
+					{
+						continue;
+					}
+
+					if (!CarromShotGenerator_PathClear(geometry, puckPos, bankPoint, puckR, target) ||
+					    !CarromShotGenerator_PathClear(geometry, bankPoint, pocketPos, puckR, target))
+					{
+						continue;
+					}
+
+					const b2Vec2 bankDirection = b2Normalize(b2Sub(mirrored, puckPos));
+					const b2Vec2 ghost = b2MulSub(puckPos, puckR + strikerR, bankDirection);
+					CarromShotGenerator_Aim(&generator, strikerPos, target, pocket, ghost, bankDirection,
+					                        CarromShotKind_PuckBank, c);
+				}
+			}
+		}
+	}
+
+	return generator.count;
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lane width of the lockstep disc engine, follows the Box2D SIMD selection
+#if defined(MACARON_ENABLE_SIMD)
+	#if defined(MACARON_AVX2)
+		#define MACARON_SIMD_AVX2
+		#define CARROM_LANES 8
+	#elif defined(__aarch64__) || defined(_M_ARM64)
+		#define MACARON_SIMD_NEON
+		#define CARROM_LANES 4
+	#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+		#define MACARON_SIMD_SSE2
+		#define CARROM_LANES 4
+	#else
+		#define MACARON_SIMD_NONE
+		#define CARROM_LANES 4
+	#endif
+#else
+	#define MACARON_SIMD_NONE
+	#define CARROM_LANES 4
+#endif
+
+#if defined(MACARON_SIMD_AVX2)
+	#include <immintrin.h>
+#elif defined(MACARON_SIMD_NEON)
+	#include <arm_neon.h>
+#elif defined(MACARON_SIMD_SSE2)
+	#include <emmintrin.h>
+#endif
+
+#include <math.h>
+
+// One float per lane, comparisons return masks with all bits of the lane set
+#if defined(MACARON_SIMD_AVX2)
+typedef __m256 CarromFloatW;
+#elif defined(MACARON_SIMD_NEON)
+typedef float32x4_t CarromFloatW;
+#elif defined(MACARON_SIMD_SSE2)
+typedef __m128 CarromFloatW;
+#else
+typedef struct CarromFloatW
+{
+	float f[CARROM_LANES];
+} CarromFloatW;
+#endif
+
+static inline CarromFloatW CarromLoadW(const float* src)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_loadu_ps(src);
+#elif defined(MACARON_SIMD_NEON)
+	return vld1q_f32(src);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_loadu_ps(src);
+#else
+	CarromFloatW a;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		a.f[i] = src[i];
+	}
+	return a;
+#endif
+}
+
+static inline void CarromStoreW(float* dst, const CarromFloatW a)
+{
+#if defined(MACARON_SIMD_AVX2)
+	_mm256_storeu_ps(dst, a);
+#elif defined(MACARON_SIMD_NEON)
+	vst1q_f32(dst, a);
+#elif defined(MACARON_SIMD_SSE2)
+	_mm_storeu_ps(dst, a);
+#else
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		dst[i] = a.f[i];
+	}
+#endif
+}
+
+static inline CarromFloatW CarromSplatW(const float scalar)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_set1_ps(scalar);
+#elif defined(MACARON_SIMD_NEON)
+	return vdupq_n_f32(scalar);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_set1_ps(scalar);
+#else
+	CarromFloatW a;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		a.f[i] = scalar;
+	}
+	return a;
+#endif
+}
+
+static inline CarromFloatW CarromZeroW(void)
+{
+	return CarromSplatW(0.0f);
+}
+
+static inline CarromFloatW CarromAddW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_add_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vaddq_f32(a, b);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_add_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = a.f[i] + b.f[i];
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromSubW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_sub_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vsubq_f32(a, b);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_sub_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = a.f[i] - b.f[i];
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromMulW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_mul_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vmulq_f32(a, b);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_mul_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = a.f[i] * b.f[i];
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromDivW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_div_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vdivq_f32(a, b);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_div_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = a.f[i] / b.f[i];
+	}
+	return c;
+#endif
+}
+
+// a + b * c
+static inline CarromFloatW CarromMulAddW(const CarromFloatW a, const CarromFloatW b, const CarromFloatW c)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_fmadd_ps(b, c, a);
+#elif defined(MACARON_SIMD_NEON)
+	return vmlaq_f32(a, b, c);
+#else
+	return CarromAddW(a, CarromMulW(b, c));
+#endif
+}
+
+// a - b * c
+static inline CarromFloatW CarromMulSubW(const CarromFloatW a, const CarromFloatW b, const CarromFloatW c)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_fnmadd_ps(b, c, a);
+#elif defined(MACARON_SIMD_NEON)
+	return vmlsq_f32(a, b, c);
+#else
+	return CarromSubW(a, CarromMulW(b, c));
+#endif
+}
+
+static inline CarromFloatW CarromSqrtW(const CarromFloatW a)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_sqrt_ps(a);
+#elif defined(MACARON_SIMD_NEON)
+	return vsqrtq_f32(a);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_sqrt_ps(a);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = sqrtf(a.f[i]);
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromMaxW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_max_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vmaxq_f32(a, b);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_max_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = a.f[i] > b.f[i] ? a.f[i] : b.f[i];
+	}
+	return c;
+#endif
+}
+
+#if defined(MACARON_SIMD_NONE)
+static inline float CarromMaskBits(const bool set)
+{
+	union
+	{
+		uint32_t u;
+		float f;
+	} bits = {set ? 0xFFFFFFFFu : 0u};
+	return bits.f;
+}
+
+static inline bool CarromIsMaskSet(const float mask)
+{
+	union
+	{
+		float f;
+		uint32_t u;
+	} bits = {mask};
+	return bits.u != 0;
+}
+#endif
+
+// a < b
+static inline CarromFloatW CarromLessW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+#elif defined(MACARON_SIMD_NEON)
+	return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_cmplt_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = CarromMaskBits(a.f[i] < b.f[i]);
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromAndW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_and_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_and_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = CarromMaskBits(CarromIsMaskSet(a.f[i]) && CarromIsMaskSet(b.f[i]));
+	}
+	return c;
+#endif
+}
+
+static inline CarromFloatW CarromOrW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_or_ps(a, b);
+#elif defined(MACARON_SIMD_NEON)
+	return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_or_ps(a, b);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = CarromMaskBits(CarromIsMaskSet(a.f[i]) || CarromIsMaskSet(b.f[i]));
+	}
+	return c;
+#endif
+}
+
+// a and not b, both masks
+static inline CarromFloatW CarromAndNotW(const CarromFloatW a, const CarromFloatW b)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_andnot_ps(b, a);
+#elif defined(MACARON_SIMD_NEON)
+	return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_andnot_ps(b, a);
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = CarromMaskBits(CarromIsMaskSet(a.f[i]) && !CarromIsMaskSet(b.f[i]));
+	}
+	return c;
+#endif
+}
+
+// mask ? b : a
+static inline CarromFloatW CarromBlendW(const CarromFloatW a, const CarromFloatW b, const CarromFloatW mask)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return _mm256_blendv_ps(a, b, mask);
+#elif defined(MACARON_SIMD_NEON)
+	return vbslq_f32(vreinterpretq_u32_f32(mask), b, a);
+#elif defined(MACARON_SIMD_SSE2)
+	return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+#else
+	CarromFloatW c;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		c.f[i] = CarromIsMaskSet(mask.f[i]) ? b.f[i] : a.f[i];
+	}
+	return c;
+#endif
+}
+
+// one bit per lane set in the mask
+static inline uint32_t CarromMaskToBitsW(const CarromFloatW mask)
+{
+#if defined(MACARON_SIMD_AVX2)
+	return (uint32_t)_mm256_movemask_ps(mask);
+#elif defined(MACARON_SIMD_NEON)
+	static const int32_t laneShifts[4] = {0, 1, 2, 3};
+	const uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+	return vaddvq_u32(vshlq_u32(signs, vld1q_s32(laneShifts)));
+#elif defined(MACARON_SIMD_SSE2)
+	return (uint32_t)_mm_movemask_ps(mask);
+#else
+	uint32_t bits = 0;
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		bits |= CarromIsMaskSet(mask.f[i]) ? 1u << i : 0u;
+	}
+	return bits;
+#endif
+}
+
+// mask with the lanes of bits set
+static inline CarromFloatW CarromBitsToMaskW(const uint32_t bits)
+{
+	union
+	{
+		uint32_t u[CARROM_LANES];
+		float f[CARROM_LANES];
+	} lanes;
+
+	for (int i = 0; i < CARROM_LANES; i++)
+	{
+		lanes.u[i] = (bits & (1u << i)) != 0 ? 0xFFFFFFFFu : 0u;
+	}
+	return CarromLoadW(lanes.f);
+}
+
+static inline float CarromGetLaneW(const CarromFloatW a, const int lane)
+{
+	float lanes[CARROM_LANES];
+	CarromStoreW(lanes, a);
+	return lanes[lane];
+}
+
+static inline CarromFloatW CarromSetLaneW(const CarromFloatW a, const int lane, const float value)
+{
+	float lanes[CARROM_LANES];
+	CarromStoreW(lanes, a);
+	lanes[lane] = value;
+	return CarromLoadW(lanes);
+}
@@ -0,0 +1,465 @@
+#include "core.h"
+#include "geometry.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// number of shots handed to CarromBatchEval at once, budgets are checked between chunks
+#define SOLVER_CHUNK_SIZE 256
+
+// initial slots of the visited set, power of two
+#define SOLVER_VISITED_CAPACITY 1024
+
+// Grid point already handed to CarromShotSolver_Add, keyed on the bits of its coordinates
+typedef struct CarromShotSolverKey
+{
+	uint32_t offset;
+	uint32_t angle;
+	uint32_t power;
+	bool used;
+} CarromShotSolverKey;
+
+typedef struct CarromShotSolverContext
+{
+	const CarromShotSolverDef* def;
+	CarromBatchDef batchDef;
+	CarromGameStatePool pool;
+	const CarromFrame* startFrame;
+	CarromTableGeometry geometry;
+	b2Vec2 forward;
+	b2Vec2 axis;
+	float baselineOffset;
+	// legal striker offsets, grid offsets are snapped into them, every offset is tried when there is none
+	CarromInterval freeIntervals[MAX_STRIKER_INTERVALS];
+	int numFreeIntervals;
+
+	// ranked solutions, best first
+	CarromShotSolution* best;
+	int bestCount;
+	int bestCapacity;
+
+	// copy of the best cells refined during a round, refineCells entries
+	CarromShotSolution* cells;
+
+	// every grid point tried so far, open addressing, refined neighbours and clamped points repeat often
+	CarromShotSolverKey* visited;
+	int visitedCount;
+	int visitedCapacity;
+
+	// candidates waiting for evaluation
+	CarromShotSolution pending[SOLVER_CHUNK_SIZE];
+	CarromShot pendingShots[SOLVER_CHUNK_SIZE];
+	CarromEvalOutcome pendingOutcomes[SOLVER_CHUNK_SIZE];
+	int pendingCount;
+
+	int evals;
+	b2Timer timer;
+	bool exhausted;
+} CarromShotSolverContext;
+
+static float CarromShotSolver_Score(const CarromShotSolverDef* def, const CarromEvalOutcome* outcome)
+{
+	int pucks = 0;
+	for (int i = 0; i < outcome->pucksHitPocket; i++)
+	{
+		if (outcome->pocketedOrder[i] != IDX_STRIKER)
+		{
+			pucks++;
+		}
+	}
+
+	float score = def->pocketScore * (float)pucks;
+	if (outcome->strikerHitPocket)
+	{
+		score -= def->foulPenalty;
+	}
+
+	return score;
+}
+
+static bool CarromShotSolver_IsBetter(const CarromShotSolution* a, const CarromShotSolution* b)
+{
+	if (a->score != b->score)
+	{
+		return a->score > b->score;
+	}
+
+	// same score, the shot that settles earlier is preferred
+	return a->outcome.numFrames < b->outcome.numFrames;
+}
+
+static void CarromShotSolver_Insert(CarromShotSolverContext* context, const CarromShotSolution* solution)
+{
+	int pos = context->bestCount;
+	while (pos > 0 && CarromShotSolver_IsBetter(solution, &context->best[pos - 1]))
+	{
+		pos--;
+	}
+
+	if (pos >= context->bestCapacity)
+	{
+		return;
+	}
+
+	const int last = context->bestCount < context->bestCapacity ? context->bestCount : context->bestCapacity - 1;
+	for (int i = last; i > pos; i--)
+	{
+		context->best[i] = context->best[i - 1];
+	}
+
+	context->best[pos] = *solution;
+	if (context->bestCount < context->bestCapacity)
+	{
+		context->bestCount++;
+	}
+}
+
+static void CarromShotSolver_Flush(CarromShotSolverContext* context)
+{
+	if (context->pendingCount == 0)
+	{
+		return;
+	}
+
+	CarromBatchEval(&context->batchDef, context->startFrame, context->pendingShots, context->pendingCount,
+	                context->pendingOutcomes);
+
+	for (int i = 0; i < context->pendingCount; i++)
+	{
+		CarromShotSolution* solution = &context->pending[i];
+		solution->outcome = context->pendingOutcomes[i];
+		solution->score = CarromShotSolver_Score(context->def, &solution->outcome);
+		CarromShotSolver_Insert(context, solution);
+	}
+
+	context->evals += context->pendingCount;
+	context->pendingCount = 0;
+
+	const float maxMilliseconds = context->def->maxMilliseconds;
+	if (maxMilliseconds > 0.0f && b2GetMilliseconds(&context->timer) >= maxMilliseconds)
+	{
+		context->exhausted = true;
+	}
+}
+
+static uint32_t CarromShotSolver_Bits(const float value)
+{
+	// negative zero is the same grid point as zero
+	const float normalized = value + 0.0f;
+	uint32_t bits;
+	memcpy(&bits, &normalized, sizeof(bits));
+	return bits;
+}
+
+static bool CarromShotSolver_InsertKey(CarromShotSolverKey* slots, const int capacity, const CarromShotSolverKey key)
+{
+	uint32_t hash = key.offset * 73856093u ^ key.angle * 19349663u ^ key.power * 83492791u;
+	for (;; hash++)
+	{
+		CarromShotSolverKey* slot = &slots[hash & (uint32_t)(capacity - 1)];
+		if (!slot->used)
+		{
+			*slot = key;
+			return true;
+		}
+		if (slot->offset == key.offset && slot->angle == key.angle && slot->power == key.power)
+		{
+			return false;
+		}
+	}
+}
+
+/**
+ * Record a grid point, false if it was tried before
+ */
+static bool CarromShotSolver_Visit(CarromShotSolverContext* context, const float offset, const float angle,
+                                   const float power)
+{
+	// keep the load under one half
+	if (2 * (context->visitedCount + 1) > context->visitedCapacity)
+	{
+		const int capacity = context->visitedCapacity > 0 ? 2 * context->visitedCapacity : SOLVER_VISITED_CAPACITY;
+		CarromShotSolverKey* slots = calloc((size_t)capacity, sizeof(CarromShotSolverKey));
+		if (slots == NULL)
+		{
+			// without a set repeats are evaluated again, which is only slower
+			return true;
+		}
+
+		for (int i = 0; i < context->visitedCapacity; i++)
+		{
+			if (context->visited[i].used)
+			{
+				CarromShotSolver_InsertKey(slots, capacity, context->visited[i]);
+			}
+		}
+		free(context->visited);
+		context->visited = slots;
+		context->visitedCapacity = capacity;
+	}
+
+	const CarromShotSolverKey key = {
+		CarromShotSolver_Bits(offset), CarromShotSolver_Bits(angle), CarromShotSolver_Bits(power), true};
+	if (!CarromShotSolver_InsertKey(context->visited, context->visitedCapacity, key))
+	{
+		return false;
+	}
+
+	context->visitedCount++;
+	return true;
+}
+
+static void CarromShotSolver_Add(CarromShotSolverContext* context, float offset, const float angle, const float power)
+{
+	if (context->exhausted)
+	{
+		return;
+	}
+
+	// blocked offsets move to the nearest legal spot with the same gap as CarromGameState_PlaceStriker,
+	// so the recorded offset is the one the striker is placed at
+	if (context->numFreeIntervals > 0)
+	{
+		offset = CarromSnapToIntervals(context->freeIntervals, context->numFreeIntervals, offset, 0.001f);
+	}
+
+	// each grid point is evaluated and ranked once, offsets snapped onto the same spot included
+	if (!CarromShotSolver_Visit(context, offset, angle, power))
+	{
+		return;
+	}
+
+	const int maxEvals = context->def->maxEvals;
+	if (maxEvals > 0 && context->evals + context->pendingCount >= maxEvals)
+	{
+		context->exhausted = true;
+		return;
+	}
+
+	CarromShotSolution* solution = &context->pending[context->pendingCount];
+	*solution = (CarromShotSolution){0};
+	solution->offset = offset;
+	solution->angle = angle;
+	solution->power = power;
+
+	CarromShot* shot = &solution->shot;
+	shot->tablePos = context->def->tablePos;
+	shot->strikerPos = b2MulSub(b2MulSV(offset, context->axis), context->baselineOffset, context->forward);
+	shot->impulse = b2MulSV(power, b2RotateVector(b2MakeRot(angle), context->forward));
+	shot->maxForce = 0.0f;
+
+	// hopeless shots never reach the physics
+	if (context->def->prefilter)
+	{
+		const CarromShotPrefilter prefilter = CarromTableGeometry_Prefilter(&context->geometry, shot);
+		if (prefilter.shotClass == CarromShotClass_Blocked)
+		{
+			return;
+		}
+	}
+
+	context->pendingShots[context->pendingCount] = *shot;
+	context->pendingCount++;
+
+	if (context->pendingCount == SOLVER_CHUNK_SIZE)
+	{
+		CarromShotSolver_Flush(context);
+	}
+}
+
+static float CarromShotSolver_GridValue(const float min, const float max, const int steps, const int i)
+{
+	if (steps <= 1)
+	{
+		return (min + max) / 2;
+	}
+
+	return min + (max - min) * (float)i / (float)(steps - 1);
+}
+
+static float CarromShotSolver_GridSpacing(const float min, const float max, const int steps)
+{
+	// a single step keeps the dimension fixed during refinement as well
+	if (steps <= 1)
+	{
+		return 0.0f;
+	}
+
+	return (max - min) / (float)(steps - 1);
+}
+
+int CarromShotSolver_Solve(const CarromShotSolverDef* def, const CarromFrame* startFrame, CarromShotSolution* solutions,
+                           const int capacity)
+{
+	MACARON_ASSERT(def != NULL);
+	MACARON_ASSERT(startFrame != NULL);
+	MACARON_ASSERT(solutions != NULL);
+	if (def == NULL || startFrame == NULL || solutions == NULL || capacity <= 0)
+	{
+		return 0;
+	}
+
+	CarromShotSolverContext* context = calloc(1, sizeof(CarromShotSolverContext));
+	if (context == NULL)
+	{
+		return 0;
+	}
+
+	context->def = def;
+	context->startFrame = startFrame;
+	context->timer = b2CreateTimer();
+	context->bestCapacity = capacity > def->refineCells ? capacity : def->refineCells;
+	context->best = malloc(sizeof(CarromShotSolution) * (size_t)context->bestCapacity);
+	if (context->best == NULL)
+	{
+		free(context);
+		return 0;
+	}
+
+	// worker states are reused by every chunk
+	context->batchDef = def->batchDef;
+	if (context->batchDef.statePool == NULL)
+	{
+		CarromGameDef gameDef = def->batchDef.gameDef;
+		gameDef.worldDef.workerCount = 1;
+
+		const bool hasTaskSystem = def->batchDef.enqueueTask != NULL && def->batchDef.finishTask != NULL;
+		const int workerCount = hasTaskSystem && def->batchDef.workerCount > 1 ? def->batchDef.workerCount : 1;
+		context->pool = CarromGameStatePool_Create(&gameDef, workerCount < MAX_BATCH_WORKERS ? workerCount : MAX_BATCH_WORKERS);
+		context->batchDef.statePool = &context->pool;
+	}
+
+	const CarromWorldDef* worldDef = &def->batchDef.gameDef.worldDef;
+	const CarromStrikerLimitDef* limitDef = &def->batchDef.gameDef.strikerLimitDef;
+
+	// forward points from the baseline towards the table center
+	switch (def->tablePos)
+	{
+		case CarromTablePosition_Bottom:
+			context->forward = (b2Vec2){0.0f, 1.0f};
+			context->axis = (b2Vec2){1.0f, 0.0f};
+			break;
+		case CarromTablePosition_Top:
+			context->forward = (b2Vec2){0.0f, -1.0f};
+			context->axis = (b2Vec2){1.0f, 0.0f};
+			break;
+		case CarromTablePosition_Left:
+			context->forward = (b2Vec2){1.0f, 0.0f};
+			context->axis = (b2Vec2){0.0f, 1.0f};
+			break;
+		case CarromTablePosition_Right:
+			context->forward = (b2Vec2){-1.0f, 0.0f};
+			context->axis = (b2Vec2){0.0f, 1.0f};
+			break;
+	}
+	context->baselineOffset = limitDef->centerOffset;
+
+	CarromTableGeometry_Init(&context->geometry, &def->batchDef.gameDef, startFrame);
+
+	const CarromGameDef* gameDef = &def->batchDef.gameDef;
+	const float strikerR = gameDef->strikerPhysicsDef.radius;
+	const float baselineHalfWidth = CarromStrikerBaselineHalfWidth(worldDef, limitDef, strikerR, def->tablePos);
+	context->numFreeIntervals = CarromStrikerFreeIntervals(
+		context->geometry.pucks, context->geometry.numPucks, def->tablePos,
+		b2MulSV(-context->baselineOffset, context->forward), baselineHalfWidth,
+		strikerR + gameDef->puckPhysicsDef.radius, context->freeIntervals);
+
+	float offsetMin = def->offsetMin;
+	float offsetMax = def->offsetMax;
+	if (offsetMin == 0.0f && offsetMax == 0.0f)
+	{
+		offsetMin = -baselineHalfWidth;
+		offsetMax = baselineHalfWidth;
+	}
+
+	const int offsetSteps = def->offsetSteps > 0 ? def->offsetSteps : 1;
+	const int angleSteps = def->angleSteps > 0 ? def->angleSteps : 1;
+	const int powerSteps = def->powerSteps > 0 ? def->powerSteps : 1;
+
+	// coarse grid
+	for (int i = 0; i < offsetSteps && !context->exhausted; i++)
+	{
+		const float offset = CarromShotSolver_GridValue(offsetMin, offsetMax, offsetSteps, i);
+		for (int j = 0; j < angleSteps && !context->exhausted; j++)
+		{
+			const float angle = CarromShotSolver_GridValue(def->angleMin, def->angleMax, angleSteps, j);
+			for (int k = 0; k < powerSteps && !context->exhausted; k++)
+			{
+				const float power = CarromShotSolver_GridValue(def->powerMin, def->powerMax, powerSteps, k);
+				CarromShotSolver_Add(context, offset, angle, power);
+			}
+		}
+	}
+	CarromShotSolver_Flush(context);
+
+	// refine around the best cells
+	float offsetDelta = CarromShotSolver_GridSpacing(offsetMin, offsetMax, offsetSteps);
+	float angleDelta = CarromShotSolver_GridSpacing(def->angleMin, def->angleMax, angleSteps);
+	float powerDelta = CarromShotSolver_GridSpacing(def->powerMin, def->powerMax, powerSteps);
+
+	if (def->refineRounds > 0 && def->refineCells > 0)
+	{
+		context->cells = malloc(sizeof(CarromShotSolution) * (size_t)def->refineCells);
+	}
+
+	for (int round = 0; round < def->refineRounds && context->cells != NULL && !context->exhausted; round++)
+	{
+		offsetDelta /= 2;
+		angleDelta /= 2;
+		powerDelta /= 2;
+
+		// the ranking changes while the neighbours are evaluated
+		CarromShotSolution* cells = context->cells;
+		const int numCells = context->bestCount < def->refineCells ? context->bestCount : def->refineCells;
+		for (int c = 0; c < numCells; c++)
+		{
+			cells[c] = context->best[c];
+		}
+
+		for (int c = 0; c < numCells && !context->exhausted; c++)
+		{
+			const CarromShotSolution* cell = &cells[c];
+			for (int i = -1; i <= 1; i++)
+			{
+				for (int j = -1; j <= 1; j++)
+				{
+					for (int k = -1; k <= 1; k++)
+					{
+						if (i == 0 && j == 0 && k == 0)
+						{
+							continue;
+						}
+
+						const float offset = b2ClampFloat(cell->offset + (float)i * offsetDelta, offsetMin, offsetMax);
+						const float angle = b2ClampFloat(cell->angle + (float)j * angleDelta, def->angleMin, def->angleMax);
+						const float power = b2ClampFloat(cell->power + (float)k * powerDelta, def->powerMin, def->powerMax);
+						CarromShotSolver_Add(context, offset, angle, power);
+					}
+				}
+			}
+		}
+		CarromShotSolver_Flush(context);
+	}
+
+	// the last chunk may have been cut short by the budget
+	CarromShotSolver_Flush(context);
+
+	const int count = context->bestCount < capacity ? context->bestCount : capacity;
+	for (int i = 0; i < count; i++)
+	{
+		solutions[i] = context->best[i];
+	}
+
+	if (context->pool.capacity > 0)
+	{
+		CarromGameStatePool_Destroy(&context->pool);
+	}
+	free(context->visited);
+	free(context->cells);
+	free(context->best);
+	free(context);
+
+	return count;
+}
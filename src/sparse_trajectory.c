@@ -0,0 +1,218 @@
+#include "core.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+
+#define DEFAULT_KEYFRAME_INTERVAL 64
+
+CarromSparseTrajectory CarromSparseTrajectory_Create(const int keyframeInterval)
+{
+	MACARON_ASSERT(keyframeInterval >= 0);
+
+	CarromSparseTrajectory trajectory = {0};
+	trajectory.keyframeInterval = keyframeInterval <= 0 ? DEFAULT_KEYFRAME_INTERVAL : keyframeInterval;
+
+	return trajectory;
+}
+
+void CarromSparseTrajectory_Clear(CarromSparseTrajectory* trajectory)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	if (trajectory == NULL)
+	{
+		return;
+	}
+
+	trajectory->strikerHitPocket = false;
+	trajectory->pucksHitPocket = 0;
+	trajectory->numFrames = 0;
+	trajectory->numEntries = 0;
+}
+
+static uint8_t CarromSparseEntry_PackFlags(const CarromObjectSnapshot* snapshot)
+{
+	uint8_t flags = 0;
+	if (snapshot->enable)
+	{
+		flags |= MACARON_SPARSE_FLAG_ENABLE;
+	}
+	if (snapshot->rest)
+	{
+		flags |= MACARON_SPARSE_FLAG_REST;
+	}
+	if (snapshot->hitPocket)
+	{
+		flags |= MACARON_SPARSE_FLAG_HIT_POCKET;
+	}
+	flags |= (uint8_t)(snapshot->hitEvent << MACARON_SPARSE_HIT_EVENT_SHIFT) & MACARON_SPARSE_HIT_EVENT_MASK;
+
+	return flags;
+}
+
+bool CarromSparseTrajectory_AppendFrame(CarromSparseTrajectory* trajectory, const CarromFrame* frame)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	MACARON_ASSERT(frame != NULL);
+	if (trajectory == NULL || frame == NULL)
+	{
+		return false;
+	}
+
+	// grow
+	if (trajectory->numFrames == trajectory->frameCapacity)
+	{
+		const int capacity = trajectory->frameCapacity == 0 ? MAX_FRAME_CAPACITY / 4 : trajectory->frameCapacity * 2;
+		CarromSparseFrame* frames = realloc(trajectory->frames, sizeof(CarromSparseFrame) * (size_t)capacity);
+		if (frames == NULL)
+		{
+			return false;
+		}
+		trajectory->frames = frames;
+		trajectory->frameCapacity = capacity;
+	}
+	if (trajectory->numEntries + NUM_OF_OBJECTS > trajectory->entryCapacity)
+	{
+		const int capacity = trajectory->entryCapacity == 0 ? MAX_FRAME_CAPACITY * 4 : trajectory->entryCapacity * 2;
+		CarromSparseEntry* entries = realloc(trajectory->entries, sizeof(CarromSparseEntry) * (size_t)capacity);
+		if (entries == NULL)
+		{
+			return false;
+		}
+		trajectory->entries = entries;
+		trajectory->entryCapacity = capacity;
+	}
+
+	const int keyframeInterval = trajectory->keyframeInterval > 0 ? trajectory->keyframeInterval : DEFAULT_KEYFRAME_INTERVAL;
+
+	CarromSparseFrame* sparseFrame = &trajectory->frames[trajectory->numFrames];
+	sparseFrame->index = frame->index;
+	sparseFrame->strikerHitPocket = frame->strikerHitPocket;
+	sparseFrame->pucksHitPocket = frame->pucksHitPocket;
+	sparseFrame->time = frame->time;
+	sparseFrame->keyframe = trajectory->numFrames % keyframeInterval == 0;
+	sparseFrame->firstEntry = trajectory->numEntries;
+	sparseFrame->numEntries = 0;
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const CarromObjectSnapshot* snapshot = &frame->snapshots[i];
+		if (!MACARON_IS_VALID_OBJ_IDX(snapshot->index))
+		{
+			continue;
+		}
+
+		CarromSparseEntry entry;
+		entry.index = snapshot->index;
+		entry.flags = CarromSparseEntry_PackFlags(snapshot);
+		entry.hitPocketIndex = snapshot->hitPocketIndex;
+		entry.position = snapshot->position;
+
+		// objects which moved are never at rest, others are only stored when their state changes
+		CarromSparseEntry* last = &trajectory->last[snapshot->index];
+		if (!sparseFrame->keyframe && snapshot->rest && last->flags == entry.flags)
+		{
+			continue;
+		}
+
+		*last = entry;
+		trajectory->entries[trajectory->numEntries++] = entry;
+		sparseFrame->numEntries++;
+	}
+
+	trajectory->strikerHitPocket |= frame->strikerHitPocket;
+	if (frame->pucksHitPocket > trajectory->pucksHitPocket)
+	{
+		trajectory->pucksHitPocket = frame->pucksHitPocket;
+	}
+	trajectory->numFrames++;
+
+	return true;
+}
+
+bool CarromSparseTrajectory_DecodeFrame(const CarromSparseTrajectory* trajectory, const int index, CarromFrame* frame)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	MACARON_ASSERT(frame != NULL);
+	if (trajectory == NULL || frame == NULL || index < 0 || index >= trajectory->numFrames)
+	{
+		return false;
+	}
+
+	*frame = (CarromFrame){0};
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		frame->snapshots[i].index = -1;
+	}
+
+	int start = index;
+	while (start > 0 && !trajectory->frames[start].keyframe)
+	{
+		start--;
+	}
+
+	for (int f = start; f <= index; f++)
+	{
+		const CarromSparseFrame* sparseFrame = &trajectory->frames[f];
+		for (int i = 0; i < sparseFrame->numEntries; i++)
+		{
+			const CarromSparseEntry* entry = &trajectory->entries[sparseFrame->firstEntry + i];
+			CarromObjectSnapshot* snapshot = &frame->snapshots[entry->index];
+
+			snapshot->index = entry->index;
+			snapshot->position = entry->position;
+			snapshot->enable = (entry->flags & MACARON_SPARSE_FLAG_ENABLE) != 0;
+			snapshot->rest = (entry->flags & MACARON_SPARSE_FLAG_REST) != 0;
+
+			// hit events only belong to the frame they happened in
+			if (f == index)
+			{
+				snapshot->hitPocket = (entry->flags & MACARON_SPARSE_FLAG_HIT_POCKET) != 0;
+				snapshot->hitPocketIndex = entry->hitPocketIndex;
+				snapshot->hitEvent =
+					(CarromHitEventType)((entry->flags & MACARON_SPARSE_HIT_EVENT_MASK) >> MACARON_SPARSE_HIT_EVENT_SHIFT);
+			}
+		}
+	}
+
+	const CarromSparseFrame* sparseFrame = &trajectory->frames[index];
+	frame->index = sparseFrame->index;
+	frame->strikerHitPocket = sparseFrame->strikerHitPocket;
+	frame->pucksHitPocket = sparseFrame->pucksHitPocket;
+	frame->time = sparseFrame->time;
+
+	return true;
+}
+
+void CarromSparseTrajectory_Destroy(CarromSparseTrajectory* trajectory)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	if (trajectory == NULL)
+	{
+		return;
+	}
+
+	free(trajectory->frames);
+	free(trajectory->entries);
+	*trajectory = (CarromSparseTrajectory){0};
+}
+
+static bool CarromSparseTrajectory_Sink(const CarromFrame* frame, void* userData)
+{
+	return CarromSparseTrajectory_AppendFrame(userData, frame);
+}
+
+int CarromGameState_EvalSparse(const CarromGameState* state, const int maxSteps, CarromSparseTrajectory* trajectory)
+{
+	MACARON_ASSERT(state != NULL);
+	MACARON_ASSERT(trajectory != NULL);
+	if (state == NULL || trajectory == NULL)
+	{
+		return 0;
+	}
+
+	CarromSparseTrajectory_Clear(trajectory);
+	CarromGameState_EvalStream(state, maxSteps, CarromSparseTrajectory_Sink, trajectory);
+
+	return trajectory->numFrames;
+}
@@ -0,0 +1,52 @@
+#include "core.h"
+
+#include <macaron/macaron.h>
+
+#include <stdlib.h>
+
+CarromTrajectory CarromTrajectory_Create(const int capacity)
+{
+	MACARON_ASSERT(capacity >= 0);
+
+	CarromTrajectory trajectory = {0};
+	CarromTrajectory_Reserve(&trajectory, capacity <= 0 ? MAX_FRAME_CAPACITY : capacity);
+
+	return trajectory;
+}
+
+bool CarromTrajectory_Reserve(CarromTrajectory* trajectory, const int capacity)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	if (trajectory == NULL)
+	{
+		return false;
+	}
+
+	if (capacity <= trajectory->capacity)
+	{
+		return true;
+	}
+
+	CarromFrame* frames = realloc(trajectory->frames, sizeof(CarromFrame) * (size_t)capacity);
+	if (frames == NULL)
+	{
+		return false;
+	}
+
+	trajectory->frames = frames;
+	trajectory->capacity = capacity;
+
+	return true;
+}
+
+void CarromTrajectory_Destroy(CarromTrajectory* trajectory)
+{
+	MACARON_ASSERT(trajectory != NULL);
+	if (trajectory == NULL)
+	{
+		return;
+	}
+
+	free(trajectory->frames);
+	*trajectory = (CarromTrajectory){0};
+}
@@ -1,4 +1,6 @@
 #include "core.h"
+#include "engine.h"
+#include "geometry.h"
 
 #include <macaron/viewer.h>
 
@@ -13,8 +15,7 @@ CarromEvalResultViewer CarromEvalResultViewerCreate(const CarromGameState* state
 
 	for (int i = 0; i < NUM_OF_OBJECTS; i++)
 	{
-		const CarromObject* obj = &state->objects[i];
-		if (B2_ID_EQUALS(obj->bodyId, b2_nullBodyId))
+		if (!CarromBody_Exists(state, i))
 		{
 			viewer.enables[i] = false;
 			viewer.positions[i] = b2Vec2_zero;
@@ -22,8 +23,8 @@ CarromEvalResultViewer CarromEvalResultViewerCreate(const CarromGameState* state
 		}
 		else
 		{
-			viewer.enables[i] = b2Body_IsEnabled(obj->bodyId);
-			viewer.positions[i] = b2Body_GetPosition(obj->bodyId);
+			viewer.enables[i] = CarromBody_IsEnabled(state, i);
+			viewer.positions[i] = CarromBody_GetPosition(state, i);
 			viewer.rest[i] = false;
 		}
 	}
@@ -37,10 +38,7 @@ CarromEvalResultViewer CarromEvalResultViewerCreate(const CarromGameState* state
 	viewer.radius[CarromObjectType_Striker] = state->strikerPhysicsDef.radius;
 	viewer.radius[CarromObjectType_Pocket] = state->pocketDef.radius;
 
-	for (int i = 0; i < MAX_POCKET_CAPACITY; i++)
-	{
-		viewer.pocketsPosition[i] = b2Shape_GetCircle(state->pockets[i]).center;
-	}
+	CarromPocketPositions(&state->worldDef, &state->pocketDef, viewer.pocketsPosition);
 
 	return viewer;
 }
@@ -64,4 +62,94 @@ void CarromEvalResultViewer_Update(CarromEvalResultViewer* viewer, const CarromF
 			viewer->rest[snapshot->index] = snapshot->rest;
 		}
 	}
+
+	viewer->time = frame->time;
+}
+
+void CarromEvalResultViewer_UpdateAt(CarromEvalResultViewer* viewer, const CarromFrame* frames, const int numFrames,
+                                     const float time)
+{
+	MACARON_ASSERT(viewer != NULL);
+	MACARON_ASSERT(frames != NULL);
+	if (viewer == NULL || frames == NULL || numFrames <= 0)
+	{
+		return;
+	}
+
+	// first frame at or after the requested time
+	int next = 0;
+	while (next < numFrames - 1 && frames[next].time < time)
+	{
+		next++;
+	}
+
+	CarromEvalResultViewer_Update(viewer, &frames[next]);
+	if (next == 0 || frames[next].time <= time)
+	{
+		return;
+	}
+
+	const CarromFrame* prev = &frames[next - 1];
+	const float duration = frames[next].time - prev->time;
+	const float alpha = duration > 0.0f ? (time - prev->time) / duration : 1.0f;
+
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		const CarromObjectSnapshot* a = &prev->snapshots[i];
+		const CarromObjectSnapshot* b = &frames[next].snapshots[i];
+		if (!MACARON_IS_VALID_OBJ_IDX(b->index) || a->index != b->index || !a->enable || !b->enable)
+		{
+			continue;
+		}
+
+		viewer->positions[b->index] = b2Lerp(a->position, b->position, alpha);
+	}
+	viewer->time = time;
+}
+
+void CarromEvalResultViewer_UpdateSparse(CarromEvalResultViewer* viewer, const CarromSparseTrajectory* trajectory,
+                                         const int index)
+{
+	MACARON_ASSERT(viewer != NULL);
+	MACARON_ASSERT(trajectory != NULL);
+	if (viewer == NULL || trajectory == NULL || index < 0 || index >= trajectory->numFrames)
+	{
+		return;
+	}
+
+	const CarromSparseFrame* frame = &trajectory->frames[index];
+	viewer->time = frame->time;
+	for (int i = 0; i < frame->numEntries; i++)
+	{
+		const CarromSparseEntry* entry = &trajectory->entries[frame->firstEntry + i];
+		if (MACARON_IS_VALID_OBJ_IDX(entry->index))
+		{
+			viewer->enables[entry->index] = (entry->flags & MACARON_SPARSE_FLAG_ENABLE) != 0;
+			viewer->positions[entry->index] = entry->position;
+			viewer->rest[entry->index] = (entry->flags & MACARON_SPARSE_FLAG_REST) != 0;
+		}
+	}
+}
+
+void CarromEvalResultViewer_UpdateSoA(CarromEvalResultViewer* viewer, const CarromFrameSoA* frame)
+{
+	MACARON_ASSERT(viewer != NULL);
+	MACARON_ASSERT(frame != NULL);
+	if (viewer == NULL || frame == NULL)
+	{
+		return;
+	}
+
+	viewer->time = frame->time;
+	for (int i = 0; i < NUM_OF_OBJECTS; i++)
+	{
+		if ((frame->validMask & MACARON_OBJ_BIT(i)) == 0)
+		{
+			continue;
+		}
+
+		viewer->enables[i] = (frame->enableMask & MACARON_OBJ_BIT(i)) != 0;
+		viewer->positions[i] = (b2Vec2){frame->x[i], frame->y[i]};
+		viewer->rest[i] = (frame->restMask & MACARON_OBJ_BIT(i)) != 0;
+	}
 }